@@ -0,0 +1,234 @@
+#ifndef E_CORO_PARALLEL_H
+#define E_CORO_PARALLEL_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/core/detail/when_all_counter.h>
+#include <e-coro/scheduler/scheduler_concept.h>
+#include <algorithm>
+#include <coroutine>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <utility>
+
+E_CORO_NS_BEGIN
+
+template<typename T>
+concept worker_pool_concept = scheduler_concept<T> && requires(T& pool) {
+   { pool.thread_count() } -> std::convertible_to<std::size_t>;
+   { pool.current_worker_index() } -> std::convertible_to<std::size_t>;
+};
+
+namespace detail {
+   // a detached coroutine, which frees itself and counts down once done.
+   struct fork_task {
+      struct promise_type {
+         template<typename ... ARGS>
+         promise_type(when_all_counter& counter, ARGS&& ...) noexcept
+            : counter_{&counter}
+         {}
+
+         auto get_return_object() noexcept { return fork_task{}; }
+         auto initial_suspend() noexcept { return std::suspend_never{}; }
+
+         auto final_suspend() noexcept {
+            struct completion_notifier {
+               bool await_ready() const noexcept { return false; }
+               void await_suspend(std::coroutine_handle<promise_type> self) const noexcept {
+                  auto* counter = self.promise().counter_;
+                  self.destroy();
+                  counter->notify_awaitable_completed();
+               }
+               void await_resume() const noexcept {}
+            };
+            return completion_notifier{};
+         }
+
+         void return_void() noexcept {}
+
+      private:
+         when_all_counter* counter_;
+      };
+   };
+
+   /////////////////////////////////////////////////////////////////////////
+   // [first, last) is split in halves until it's no bigger than grain; the
+   // upper half is forked onto the pool, the lower half is kept going on.
+   // Thus only about size/grain frames are created, and a thief always
+   // takes the biggest piece left. The awaiting coroutine is resumed by
+   // whoever finishes the last piece.
+   /////////////////////////////////////////////////////////////////////////
+   template<typename DERIVED, worker_pool_concept POOL>
+   struct parallel_awaitable {
+      parallel_awaitable(POOL& pool, std::size_t size, std::size_t grain) noexcept
+         : pool_{pool}
+         , size_{size}
+         , grain_{grain > 0 ? grain : default_grain(pool, size)}
+         , counter_{1}
+      {}
+
+      parallel_awaitable(parallel_awaitable const&) = delete;
+      parallel_awaitable& operator=(parallel_awaitable const&) = delete;
+
+      auto await_ready() const noexcept -> bool {
+         return size_ == 0;
+      }
+
+      auto await_suspend(std::coroutine_handle<> awaiting) noexcept -> bool {
+         fork(counter_, *this, 0, size_);
+         return counter_.try_await(awaiting);
+      }
+
+   protected:
+      POOL& pool_;
+
+   private:
+      static auto default_grain(POOL& pool, std::size_t size) noexcept -> std::size_t {
+         // a few pieces per worker, for load balancing.
+         return std::max<std::size_t>(size / (pool.thread_count() * 8), 1);
+      }
+
+      static auto fork(when_all_counter&, parallel_awaitable& self, std::size_t first, std::size_t last)
+      -> fork_task {
+         co_await self.pool_.schedule();
+         self.split(first, last);
+      }
+
+      auto split(std::size_t first, std::size_t last) noexcept {
+         while(last - first > grain_) {
+            auto middle = first + (last - first) / 2;
+            counter_.add_awaitables(1);
+            fork(counter_, *this, middle, last);
+            last = middle;
+         }
+         static_cast<DERIVED&>(*this).run_leaf(first, last);
+      }
+
+   private:
+      const std::size_t size_;
+      const std::size_t grain_;
+      when_all_counter counter_;
+   };
+
+   template<typename R>
+   inline auto iterator_at(R& range, std::size_t index) {
+      return std::ranges::begin(range) + static_cast<std::ranges::range_difference_t<R>>(index);
+   }
+
+   template<typename POOL, typename R, typename F>
+   struct parallel_for_awaitable
+      : parallel_awaitable<parallel_for_awaitable<POOL, R, F>, POOL> {
+      using super = parallel_awaitable<parallel_for_awaitable<POOL, R, F>, POOL>;
+
+      template<typename RANGE, typename FUNC>
+      parallel_for_awaitable(POOL& pool, RANGE&& range, std::size_t grain, FUNC&& func)
+         : super{pool, static_cast<std::size_t>(std::ranges::size(range)), grain}
+         , range_{std::forward<RANGE>(range)}
+         , func_{std::forward<FUNC>(func)}
+      {}
+
+      auto await_resume() const noexcept {}
+
+   private:
+      friend super;
+
+      auto run_leaf(std::size_t first, std::size_t last) {
+         auto end = iterator_at(range_, last);
+         for(auto i = iterator_at(range_, first); i != end; ++i) {
+            std::invoke(func_, *i);
+         }
+      }
+
+   private:
+      R range_;
+      F func_;
+   };
+
+   template<typename POOL, typename R, typename T, typename OP>
+   struct parallel_reduce_awaitable
+      : parallel_awaitable<parallel_reduce_awaitable<POOL, R, T, OP>, POOL> {
+      using super = parallel_awaitable<parallel_reduce_awaitable<POOL, R, T, OP>, POOL>;
+
+      template<typename RANGE, typename INIT, typename FUNC>
+      parallel_reduce_awaitable(POOL& pool, RANGE&& range, INIT&& init, FUNC&& op, std::size_t grain)
+         : super{pool, static_cast<std::size_t>(std::ranges::size(range)), grain}
+         , range_{std::forward<RANGE>(range)}
+         , init_{std::forward<INIT>(init)}
+         , op_{std::forward<FUNC>(op)}
+         , partials_{std::make_unique<partial[]>(pool.thread_count())}
+      {}
+
+      auto await_resume() -> T {
+         T result = std::move(init_);
+         for(std::size_t i = 0; i < super::pool_.thread_count(); ++i) {
+            if(partials_[i].value_) {
+               result = std::invoke(op_, std::move(result), std::move(*partials_[i].value_));
+            }
+         }
+         return result;
+      }
+
+   private:
+      friend super;
+
+      auto run_leaf(std::size_t first, std::size_t last) {
+         auto i = iterator_at(range_, first);
+         auto end = iterator_at(range_, last);
+         T value = *i;
+         for(++i; i != end; ++i) {
+            value = std::invoke(op_, std::move(value), *i);
+         }
+
+         // each worker folds into its own slot, no one else touches it.
+         auto& slot = partials_[super::pool_.current_worker_index()].value_;
+         if(slot) {
+            *slot = std::invoke(op_, std::move(*slot), std::move(value));
+         } else {
+            slot.emplace(std::move(value));
+         }
+      }
+
+   private:
+      struct alignas(64) partial {
+         std::optional<T> value_;
+      };
+
+      R range_;
+      T init_;
+      OP op_;
+      std::unique_ptr<partial[]> partials_;
+   };
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// co_await parallel_for(pool, range, grain, f) calls f(element) for each
+// element of the range on the workers of pool; grain is the size of the
+// pieces a worker runs at a time, 0 to let it decide. The awaiting coroutine
+// is resumed on a worker of pool.
+/////////////////////////////////////////////////////////////////////////////
+template<worker_pool_concept POOL, std::ranges::random_access_range R, typename F>
+requires std::ranges::sized_range<R>
+[[nodiscard("this is an awaitable")]]
+inline auto parallel_for(POOL& pool, R&& range, std::size_t grain, F&& func) {
+   using awaitable_t = detail::parallel_for_awaitable<POOL, std::views::all_t<R>, std::decay_t<F>>;
+   return awaitable_t{pool, std::views::all(std::forward<R>(range)), grain, std::forward<F>(func)};
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// co_await parallel_reduce(pool, range, init, op) folds the range with op,
+// which should be associative and commutative, since pieces are combined
+// in whatever order they are done.
+/////////////////////////////////////////////////////////////////////////////
+template<worker_pool_concept POOL, std::ranges::random_access_range R, typename T, typename OP>
+requires std::ranges::sized_range<R>
+[[nodiscard("this is an awaitable")]]
+inline auto parallel_reduce(POOL& pool, R&& range, T init, OP&& op, std::size_t grain = 0) {
+   using awaitable_t = detail::parallel_reduce_awaitable<POOL, std::views::all_t<R>, T, std::decay_t<OP>>;
+   return awaitable_t{pool, std::views::all(std::forward<R>(range)), std::move(init), std::forward<OP>(op), grain};
+}
+
+E_CORO_NS_END
+
+#endif //E_CORO_PARALLEL_H
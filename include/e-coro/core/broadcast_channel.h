@@ -0,0 +1,446 @@
+#ifndef E_CORO_BROADCAST_CHANNEL_H
+#define E_CORO_BROADCAST_CHANNEL_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/scheduler/schedule_node.h>
+#include <algorithm>
+#include <bit>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+E_CORO_NS_BEGIN
+
+// what a channel does about a subscriber the ring is full of.
+enum class broadcast_policy {
+   // overwrite what it's not read yet, and count it as lagged.
+   drop_oldest,
+   // suspend the publisher till it's read.
+   backpressure,
+};
+
+namespace detail {
+   // a coroutine suspended on a channel, resumed right there, or handed over
+   // to a run queue of its own.
+   struct broadcast_waiter {
+      auto wake() noexcept -> void {
+         if(push_ == nullptr) node_.resume();
+         else push_(queue_, node_);
+      }
+
+      template<typename Q>
+      auto resume_via(Q& queue) noexcept -> void {
+         queue_ = std::addressof(queue);
+         push_ = [](void* queue, schedule_node& node) noexcept {
+            static_cast<Q*>(queue)->push(node);
+         };
+      }
+
+      broadcast_waiter* next_{};
+      schedule_node node_;
+      void* queue_{};
+      void (*push_)(void*, schedule_node&) noexcept {};
+   };
+
+   // the ones to wake once the lock is released.
+   struct broadcast_wake_list {
+      auto add(broadcast_waiter& waiter) noexcept -> void {
+         waiter.next_ = head_;
+         head_ = &waiter;
+      }
+
+      auto wake() noexcept -> void {
+         while(head_ != nullptr) {
+            // it could be gone once it's resumed.
+            auto next = head_->next_;
+            head_->wake();
+            head_ = next;
+         }
+      }
+
+   private:
+      broadcast_waiter* head_{};
+   };
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Values published to many subscribers through a single ring: each value
+// is stored once, and every subscriber reads it in place, from a cursor of
+// its own:
+//
+//    broadcast_channel<tick> ticks{1024, broadcast_policy::drop_oldest};
+//    auto sub = ticks.subscribe();
+//
+//    co_await ticks.publish(t);                     // the publisher
+//
+//    while(auto t = co_await sub.next()) {          // a subscriber
+//       on_tick(*t);
+//    }
+//
+// A subscriber suspends in next() once it's caught up, and gets nullptr
+// once the channel is closed and it's read everything. The value it gets
+// is valid till it calls next() again; till then, its slot is not reused.
+//
+// Once the ring is full of values a subscriber is yet to read, the policy
+// of the channel decides: drop_oldest moves its cursor on, and counts the
+// values it's missed in lagged(); backpressure suspends the publisher till
+// the slowest subscriber reads the oldest. A value still held by one is no
+// reason to wait, though: its slot is set aside till it's let go, and a
+// spare one takes its place in the ring; there's a spare for every
+// subscriber, which holds one value at most. Thus with drop_oldest, a
+// publisher never waits.
+//
+// Any thread could publish, or read; the state is guarded by a mutex, and
+// nobody is resumed with it held. The ones suspended are resumed by
+// whoever makes the progress they wait for, unless resume_via(queue) is
+// given to the awaiter.
+/////////////////////////////////////////////////////////////////////////////
+template<typename T>
+struct broadcast_channel {
+   struct subscriber;
+   struct publish_operation;
+
+   // capacity is rounded up to a power of 2.
+   explicit broadcast_channel(std::size_t capacity, broadcast_policy policy = broadcast_policy::drop_oldest)
+      : capacity_{std::bit_ceil(std::max<std::size_t>(capacity, 1))}
+      , policy_{policy}
+      , slots_{std::make_unique<slot[]>(capacity_)}
+      , ring_{std::make_unique<slot*[]>(capacity_)} {
+      for(std::size_t i = 0; i < capacity_; ++i) ring_[i] = &slots_[i];
+   }
+
+   broadcast_channel(broadcast_channel const&) = delete;
+   broadcast_channel& operator=(broadcast_channel const&) = delete;
+
+   // reads what's published from now on.
+   auto subscribe() -> subscriber;
+
+   // resumes with false if the channel's closed before it's published.
+   [[nodiscard("this is an awaitable")]]
+   auto publish(T value) -> publish_operation;
+
+   // the pending publishers fail; subscribers get what's published already.
+   auto close() noexcept -> void {
+      detail::broadcast_wake_list woken;
+      {
+         std::lock_guard lock{mutex_};
+         closed_ = true;
+         for(auto c : cursors_) {
+            if(c->waiting_ != nullptr) {
+               c->current_ = nullptr;
+               woken.add(*std::exchange(c->waiting_, nullptr));
+            }
+         }
+         while(publishers_ != nullptr) {
+            auto p = std::exchange(publishers_, publishers_->next_);
+            p->published_ = false;
+            woken.add(p->waiter_);
+         }
+         publishers_tail_ = nullptr;
+      }
+      woken.wake();
+   }
+
+   auto capacity() const noexcept -> std::size_t {
+      return capacity_;
+   }
+
+private:
+   struct slot {
+      std::optional<T> value_;
+      // the subscribers holding it.
+      std::size_t holders_{};
+      // out of the ring, till it's let go.
+      bool set_aside_{false};
+   };
+
+   struct cursor {
+      // the next to read.
+      std::uint64_t next_{};
+      // values overwritten before being read.
+      std::uint64_t lagged_{};
+      // the one read last, not to be overwritten till next() is called.
+      slot* held_{};
+      const T* current_{};
+      detail::broadcast_waiter* waiting_{};
+   };
+
+   auto ring(std::uint64_t sequence) noexcept -> slot*& {
+      return ring_[sequence & (capacity_ - 1)];
+   }
+
+   auto take(cursor& c) noexcept -> void {
+      c.held_ = ring(c.next_++);
+      ++c.held_->holders_;
+      c.current_ = &*c.held_->value_;
+   }
+
+   // a slot set aside is a spare again, once nobody holds it.
+   auto let_go(cursor& c) noexcept -> void {
+      auto s = std::exchange(c.held_, nullptr);
+      if(--s->holders_ == 0 && s->set_aside_) {
+         s->set_aside_ = false;
+         spares_.push_back(s);
+      }
+   }
+
+   // with the lock held.
+   auto try_write(T& value, detail::broadcast_wake_list& woken) noexcept -> bool {
+      if(write_ >= capacity_) {
+         // the one to be overwritten.
+         auto oldest = write_ - capacity_;
+         for(auto c : cursors_) {
+            if(policy_ == broadcast_policy::drop_oldest && c->next_ <= oldest) {
+               c->lagged_ += oldest + 1 - c->next_;
+               c->next_ = oldest + 1;
+            }
+            if(c->next_ <= oldest) return false;
+         }
+      }
+      auto& s = ring(write_);
+      if(s->holders_ > 0) {
+         // a subscriber holds one slot at most, so there's a spare.
+         s->set_aside_ = true;
+         s = spares_.back();
+         spares_.pop_back();
+      }
+      s->value_.emplace(std::move(value));
+      ++write_;
+      for(auto c : cursors_) {
+         if(c->waiting_ != nullptr) {
+            take(*c);
+            woken.add(*std::exchange(c->waiting_, nullptr));
+         }
+      }
+      return true;
+   }
+
+   // with the lock held, once a subscriber's moved on.
+   auto drain_publishers(detail::broadcast_wake_list& woken) noexcept -> void {
+      while(publishers_ != nullptr && try_write(publishers_->value_, woken)) {
+         auto p = std::exchange(publishers_, publishers_->next_);
+         p->published_ = true;
+         woken.add(p->waiter_);
+      }
+      if(publishers_ == nullptr) publishers_tail_ = nullptr;
+   }
+
+   // whether it's to suspend.
+   auto wait_next(cursor& c, detail::broadcast_waiter& waiter) noexcept -> bool {
+      detail::broadcast_wake_list woken;
+      bool suspended = false;
+      {
+         std::lock_guard lock{mutex_};
+         if(c.held_ != nullptr) {
+            let_go(c);
+            drain_publishers(woken);
+         }
+         if(c.next_ < write_) {
+            take(c);
+         } else if(closed_) {
+            c.current_ = nullptr;
+         } else {
+            c.waiting_ = &waiter;
+            suspended = true;
+         }
+      }
+      woken.wake();
+      return suspended;
+   }
+
+   auto wait_publish(publish_operation& p) noexcept -> bool {
+      detail::broadcast_wake_list woken;
+      bool suspended = false;
+      {
+         std::lock_guard lock{mutex_};
+         if(closed_) {
+            p.published_ = false;
+         } else if(publishers_ == nullptr && try_write(p.value_, woken)) {
+            p.published_ = true;
+         } else {
+            // behind the ones waiting already.
+            p.next_ = nullptr;
+            if(publishers_tail_ == nullptr) publishers_ = &p;
+            else publishers_tail_->next_ = &p;
+            publishers_tail_ = &p;
+            suspended = true;
+         }
+      }
+      woken.wake();
+      return suspended;
+   }
+
+   auto add(cursor& c) -> void {
+      std::lock_guard lock{mutex_};
+      // a spare for every subscriber there's been at once.
+      if(spare_slots_.size() == cursors_.size()) {
+         spare_slots_.push_back(std::make_unique<slot>());
+         // let_go() doesn't allocate.
+         spares_.reserve(spare_slots_.size());
+         spares_.push_back(spare_slots_.back().get());
+      }
+      c.next_ = write_;
+      cursors_.push_back(&c);
+   }
+
+   auto remove(cursor& c) noexcept -> void {
+      detail::broadcast_wake_list woken;
+      {
+         std::lock_guard lock{mutex_};
+         if(c.held_ != nullptr) let_go(c);
+         cursors_.erase(std::find(cursors_.begin(), cursors_.end(), &c));
+         drain_publishers(woken);
+      }
+      woken.wake();
+   }
+
+   auto lagged(cursor const& c) noexcept -> std::uint64_t {
+      std::lock_guard lock{mutex_};
+      return c.lagged_;
+   }
+
+private:
+   const std::size_t capacity_;
+   const broadcast_policy policy_;
+   std::unique_ptr<slot[]> slots_;
+   std::unique_ptr<slot*[]> ring_;
+   std::vector<std::unique_ptr<slot>> spare_slots_;
+   // the slots out of the ring, held by nobody.
+   std::vector<slot*> spares_;
+   std::mutex mutex_;
+   // the next to write.
+   std::uint64_t write_{0};
+   std::vector<cursor*> cursors_;
+   // the ones waiting for a slot, FIFO.
+   publish_operation* publishers_{};
+   publish_operation* publishers_tail_{};
+   bool closed_{false};
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// A cursor into a channel, which is to outlive it. Not to be destroyed while
+// it's suspended in next().
+/////////////////////////////////////////////////////////////////////////////
+template<typename T>
+struct broadcast_channel<T>::subscriber {
+   subscriber(subscriber&&) noexcept = default;
+   subscriber& operator=(subscriber&&) = delete;
+
+   ~subscriber() {
+      if(cursor_ != nullptr) channel_->remove(*cursor_);
+   }
+
+   struct next_operation {
+      auto await_ready() const noexcept -> bool {
+         return false;
+      }
+
+      auto await_suspend(std::coroutine_handle<> h) noexcept -> bool {
+         waiter_.node_.handle_ = h;
+         return channel_.wait_next(cursor_, waiter_);
+      }
+
+      // nullptr once it's closed, and everything's read.
+      auto await_resume() const noexcept -> const T* {
+         return cursor_.current_;
+      }
+
+      template<schedule_queue_concept Q>
+      auto resume_via(Q& queue) & noexcept -> next_operation& {
+         waiter_.resume_via(queue);
+         return *this;
+      }
+
+      template<schedule_queue_concept Q>
+      auto resume_via(Q& queue) && noexcept -> next_operation&& {
+         return std::move(resume_via(queue));
+      }
+
+      broadcast_channel& channel_;
+      cursor& cursor_;
+      detail::broadcast_waiter waiter_{};
+   };
+
+   [[nodiscard("this is an awaitable")]]
+   auto next() noexcept -> next_operation {
+      return next_operation{*channel_, *cursor_};
+   }
+
+   // the values it's missed, by drop_oldest.
+   auto lagged() const noexcept -> std::uint64_t {
+      return channel_->lagged(*cursor_);
+   }
+
+private:
+   friend struct broadcast_channel;
+
+   explicit subscriber(broadcast_channel& channel)
+      : channel_{&channel}
+      , cursor_{std::make_unique<cursor>()} {
+      channel_->add(*cursor_);
+   }
+
+   broadcast_channel* channel_;
+   std::unique_ptr<cursor> cursor_;
+};
+
+template<typename T>
+struct broadcast_channel<T>::publish_operation {
+   publish_operation(broadcast_channel& channel, T&& value)
+      : channel_{channel}
+      , value_{std::move(value)}
+   {}
+
+   auto await_ready() const noexcept -> bool {
+      return false;
+   }
+
+   auto await_suspend(std::coroutine_handle<> h) noexcept -> bool {
+      waiter_.node_.handle_ = h;
+      return channel_.wait_publish(*this);
+   }
+
+   // whether it's published.
+   auto await_resume() const noexcept -> bool {
+      return published_;
+   }
+
+   template<schedule_queue_concept Q>
+   auto resume_via(Q& queue) & noexcept -> publish_operation& {
+      waiter_.resume_via(queue);
+      return *this;
+   }
+
+   template<schedule_queue_concept Q>
+   auto resume_via(Q& queue) && noexcept -> publish_operation&& {
+      return std::move(resume_via(queue));
+   }
+
+private:
+   friend struct broadcast_channel;
+
+   broadcast_channel& channel_;
+   T value_;
+   detail::broadcast_waiter waiter_{};
+   publish_operation* next_{};
+   bool published_{false};
+};
+
+template<typename T>
+inline auto broadcast_channel<T>::subscribe() -> subscriber {
+   return subscriber{*this};
+}
+
+template<typename T>
+inline auto broadcast_channel<T>::publish(T value) -> publish_operation {
+   return publish_operation{*this, std::move(value)};
+}
+
+E_CORO_NS_END
+
+#endif //E_CORO_BROADCAST_CHANNEL_H
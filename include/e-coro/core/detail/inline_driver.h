@@ -0,0 +1,79 @@
+#ifndef E_CORO_INLINE_DRIVER_H
+#define E_CORO_INLINE_DRIVER_H
+
+#include <e-coro/e_coro_ns.h>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <new>
+
+E_CORO_NS_BEGIN namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////
+// Room for the frame of a driver coroutine, kept in the awaiter it drives
+// the stages of. The size of a frame is up to the compiler: a driver taking
+// a couple of references, and awaiting an awaiter_ref or two, takes about
+// 90 bytes with GCC; one that doesn't fit is allocated as usual, and
+// counted in overflows(), which is to stay 0.
+/////////////////////////////////////////////////////////////////////////////
+struct inline_frame {
+   constexpr static std::size_t capacity = 128;
+
+   static auto overflows() noexcept -> std::size_t {
+      return overflows_.load(std::memory_order_relaxed);
+   }
+
+   alignas(std::max_align_t) std::byte storage_[capacity];
+
+   inline static std::atomic<std::size_t> overflows_{0};
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// A coroutine whose frame is placed into the inline_frame given as its first
+// argument, which is to outlive it. It's started by resuming handle_; once
+// it's done, on_done_(context_) gives the one to transfer to. It's destroyed
+// by the owner, suspended for good by then.
+/////////////////////////////////////////////////////////////////////////////
+struct inline_driver {
+   struct promise_type {
+      template<typename ... ARGS>
+      static auto operator new(std::size_t size, inline_frame& frame, ARGS& ...) -> void* {
+         if(size <= inline_frame::capacity) return frame.storage_;
+         inline_frame::overflows_.fetch_add(1, std::memory_order_relaxed);
+         return ::operator new(size);
+      }
+
+      static auto operator delete(void* frame, std::size_t size) noexcept -> void {
+         if(size > inline_frame::capacity) ::operator delete(frame, size);
+      }
+
+      auto get_return_object() noexcept -> inline_driver {
+         return inline_driver{std::coroutine_handle<promise_type>::from_promise(*this)};
+      }
+      auto initial_suspend() noexcept { return std::suspend_always{}; }
+      auto final_suspend() noexcept {
+         struct awaiter : std::suspend_always {
+            auto await_suspend(std::coroutine_handle<promise_type> h) noexcept -> std::coroutine_handle<> {
+               auto& promise = h.promise();
+               return promise.on_done_(promise.context_);
+            }
+         };
+         return awaiter{};
+      }
+      auto return_void() noexcept {}
+
+      void* context_{};
+      std::coroutine_handle<> (*on_done_)(void*) noexcept {};
+   };
+
+   std::coroutine_handle<promise_type> handle_;
+};
+
+// on_done_ of a driver resuming whoever awaits it, the context.
+inline auto resume_caller(void* caller) noexcept -> std::coroutine_handle<> {
+   return std::coroutine_handle<>::from_address(caller);
+}
+
+} E_CORO_NS_END
+
+#endif //E_CORO_INLINE_DRIVER_H
@@ -0,0 +1,78 @@
+#ifndef E_CORO_PROMISE_HOOKS_H
+#define E_CORO_PROMISE_HOOKS_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/core/awaitable_trait.h>
+#include <coroutine>
+#include <type_traits>
+#include <utility>
+
+E_CORO_NS_BEGIN namespace detail {
+
+// co_await an awaiter through HOOKS: on_suspend() right before it suspends,
+// since i might be resumed, or even gone, right after; on_resume() once i'm
+// resumed. If it turns out i'm not suspended after all, as await_suspend()
+// gives false or myself back, on_suspend_cancelled() instead; and nothing
+// at all if it's ready.
+template<typename HOOKS, typename AWAITER>
+struct hooked_awaiter {
+   auto await_ready() -> bool {
+      return awaiter_.await_ready();
+   }
+
+   template<typename P>
+   auto await_suspend(std::coroutine_handle<P> self) -> decltype(auto) {
+      using result_t = decltype(awaiter_.await_suspend(self));
+      // set before, it's read by whoever resumes me.
+      suspended_ = true;
+      hooks_->on_suspend();
+      if constexpr(std::is_void_v<result_t>) {
+         awaiter_.await_suspend(self);
+      } else {
+         // not suspended, thus nobody else is to touch me.
+         auto next = awaiter_.await_suspend(self);
+         if constexpr(std::is_same_v<result_t, bool>) {
+            if(!next) cancel();
+         } else {
+            if(next.address() == self.address()) cancel();
+         }
+         return next;
+      }
+   }
+
+   auto await_resume() -> decltype(auto) {
+      if(suspended_) hooks_->on_resume();
+      return awaiter_.await_resume();
+   }
+
+   // an awaiter given by reference lives through the whole co_await.
+   AWAITER awaiter_;
+   HOOKS* hooks_;
+   bool suspended_{false};
+
+private:
+   auto cancel() -> void {
+      suspended_ = false;
+      hooks_->on_suspend_cancelled();
+   }
+};
+
+template<typename HOOKS, awaitable_concept A>
+inline auto hook_awaiter(HOOKS& hooks, A&& awaitable) {
+   using awaiter_t = decltype(get_awaiter(std::forward<A>(awaitable)));
+   return hooked_awaiter<HOOKS, awaiter_t>{get_awaiter(std::forward<A>(awaitable)), &hooks};
+}
+
+// the initial suspension of a lazy coroutine, on_start() once it's resumed.
+template<typename HOOKS>
+struct hooked_initial_suspend : std::suspend_always {
+   auto await_resume() const noexcept -> void {
+      hooks_->on_start();
+   }
+
+   HOOKS* hooks_;
+};
+
+} E_CORO_NS_END
+
+#endif //E_CORO_PROMISE_HOOKS_H
@@ -0,0 +1,182 @@
+#ifndef E_CORO_WHEN_ALL_AWAITER_TASK_H
+#define E_CORO_WHEN_ALL_AWAITER_TASK_H
+
+#include <e-coro/core/detail/when_all_counter.h>
+#include <e-coro/core/detail/when_all_task.h>
+#include <e-coro/core/detail/inline_driver.h>
+#include <e-coro/core/awaitable_trait.h>
+#include <e-coro/core/then.h>
+#include <coroutine>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+E_CORO_NS_BEGIN namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////
+// A child of when_all_ready whose awaitable, awaiter and result are all kept
+// right here, inside the when_all_ready_awaitable, thus nothing is allocated
+// for the child but what the awaitable allocates itself.
+//
+// Unlike the when_all_task it replaces, which took a copy of any awaitable,
+// an lvalue awaitable is kept by reference: it has to outlive the
+// when_all_ready_awaitable, and a move-only one can be passed as well.
+//
+// A result given by rvalue reference is moved in, since it might be into
+// the awaitable or the awaiter kept here, which don't move along with it.
+// One given by lvalue reference is kept as a pointer.
+//
+// If it's ready, it's done right away. Otherwise it's awaited by a driver
+// coroutine, whose frame is in place too, in an inline_frame.
+/////////////////////////////////////////////////////////////////////////////
+template<typename A, typename COUNTER = when_all_counter>
+struct when_all_awaiter_task final {
+private:
+   using get_awaiter_t = decltype(get_awaiter(std::declval<A>()));
+   // an awaiter given by reference is the awaitable itself, kept already.
+   constexpr static bool owns_awaiter = !std::is_reference_v<get_awaiter_t>;
+   using awaiter_type = std::remove_reference_t<get_awaiter_t>;
+   using reference_type = decltype(std::declval<awaiter_type&>().await_resume());
+   constexpr static bool is_void = std::is_void_v<reference_type>;
+   constexpr static bool by_pointer = std::is_lvalue_reference_v<reference_type>;
+   using stored_type = std::conditional_t<by_pointer,
+      std::remove_reference_t<reference_type>*,
+      std::conditional_t<std::is_rvalue_reference_v<reference_type>,
+      std::remove_cvref_t<reference_type>,
+      std::conditional_t<is_void, char, reference_type>>>;
+
+public:
+   explicit when_all_awaiter_task(A&& awaitable) noexcept
+      : awaitable_{std::forward<A>(awaitable)}
+   {}
+
+   // before it's started, or after it's completed, when only the result is
+   // taken along; only an lvalue result is kept by pointer, to something
+   // out of me.
+   when_all_awaiter_task(when_all_awaiter_task&& other) noexcept
+      : awaitable_{std::forward<A>(other.awaitable_)}
+      , has_result_{other.has_result_} {
+      if(has_result_) {
+         ::new(static_cast<void*>(std::addressof(result_))) stored_type(std::move(other.result_));
+      }
+   }
+
+   when_all_awaiter_task(const when_all_awaiter_task&) = delete;
+   when_all_awaiter_task& operator=(const when_all_awaiter_task&) = delete;
+
+   ~when_all_awaiter_task() noexcept {
+      if(driver_) driver_.destroy();
+      if(has_result_) std::destroy_at(&result_);
+      if constexpr(owns_awaiter) {
+         if(started_) std::destroy_at(&awaiter_);
+      }
+   }
+
+   auto result() & -> decltype(auto) {
+      if constexpr(is_void) {
+         return;
+      } else if constexpr(by_pointer) {
+         return static_cast<reference_type>(*result_);
+      } else {
+         return static_cast<stored_type&>(result_);
+      }
+   }
+
+   auto result() && -> decltype(auto) {
+      if constexpr(is_void) {
+         return;
+      } else if constexpr(by_pointer) {
+         return static_cast<reference_type>(*result_);
+      } else {
+         return static_cast<stored_type&&>(result_);
+      }
+   }
+
+   auto non_void_result() & -> decltype(auto) {
+      if constexpr(is_void) {
+         return void_value{};
+      } else {
+         return this->result();
+      }
+   }
+
+   auto non_void_result() && -> decltype(auto) {
+      if constexpr(is_void) {
+         return void_value{};
+      } else {
+         return std::move(*this).result();
+      }
+   }
+
+private:
+   template<typename TASK_CONTAINER>
+   friend struct when_all_ready_awaitable;
+
+   auto awaiter() noexcept -> awaiter_type& {
+      if constexpr(owns_awaiter) {
+         return awaiter_;
+      } else {
+         return awaitable_;
+      }
+   }
+
+   auto start(COUNTER& counter) noexcept -> void {
+      counter_ = &counter;
+      if constexpr(owns_awaiter) {
+         ::new(static_cast<void*>(std::addressof(awaiter_))) awaiter_type(get_awaiter(static_cast<A&&>(awaitable_)));
+      }
+      started_ = true;
+
+      if(awaiter().await_ready()) {
+         complete();
+         return;
+      }
+
+      driver_ = drive(frame_, *this).handle_;
+      driver_.promise().context_ = this;
+      driver_.promise().on_done_ = [](void* self) noexcept -> std::coroutine_handle<> {
+         // the driver is suspended for good, it's destroyed along with me.
+         static_cast<when_all_awaiter_task*>(self)->complete();
+         return std::noop_coroutine();
+      };
+      driver_.resume();
+   }
+
+   static auto drive(inline_frame&, when_all_awaiter_task& self) -> inline_driver {
+      co_await awaiter_ref{self.awaiter()};
+   }
+
+   auto complete() noexcept -> void {
+      if constexpr(is_void) {
+         awaiter().await_resume();
+      } else {
+         if constexpr(by_pointer) {
+            auto&& result = awaiter().await_resume();
+            result_ = std::addressof(result);
+         } else {
+            ::new(static_cast<void*>(std::addressof(result_))) stored_type(awaiter().await_resume());
+         }
+         has_result_ = true;
+         if constexpr(requires { counter_->on_result(this->result()); }) {
+            counter_->on_result(this->result());
+         }
+      }
+      // i might be gone right after.
+      counter_->notify_awaitable_completed();
+   }
+
+private:
+   A awaitable_;
+   COUNTER* counter_{};
+   std::coroutine_handle<inline_driver::promise_type> driver_;
+   bool started_{false};
+   bool has_result_{false};
+   union { std::conditional_t<owns_awaiter, awaiter_type, char> awaiter_; };
+   union { stored_type result_; };
+   inline_frame frame_;
+};
+
+} E_CORO_NS_END
+
+#endif //E_CORO_WHEN_ALL_AWAITER_TASK_H
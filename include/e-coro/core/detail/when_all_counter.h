@@ -6,36 +6,64 @@
 #define E_CORO_WHEN_ALL_COUNTER_H
 
 #include <e-coro/e_coro_ns.h>
+#include <e-coro/scheduler/schedule_node.h>
 #include <cstddef>
 #include <atomic>
 #include <coroutine>
+#include <memory>
 
 E_CORO_NS_BEGIN namespace detail {
 
 struct when_all_counter {
    when_all_counter(std::size_t count) noexcept
       : count_(count + 1)
-      , awaiting_(nullptr)
    {}
 
    auto is_ready() const noexcept -> bool {
-      return static_cast<bool>(awaiting_);
+      return static_cast<bool>(awaiting_.handle_);
    }
 
    auto try_await(std::coroutine_handle<> awaiting) noexcept -> bool {
-      awaiting_ = awaiting;
+      awaiting_.handle_ = awaiting;
       return count_.fetch_sub(1, std::memory_order_acq_rel) > 1;
    }
 
+   // the awaiting one is handed over to queue by the last to complete,
+   // rather than being resumed by it right there.
+   template<schedule_queue_concept Q>
+   auto resume_via(Q& queue) noexcept {
+      queue_ = std::addressof(queue);
+      push_ = [](void* queue, schedule_node& node) noexcept {
+         static_cast<Q*>(queue)->push(node);
+      };
+   }
+
+   // for a dynamic fan-out, the count could be raised, as long as the one
+   // raising it has not completed yet.
+   auto add_awaitables(std::size_t count) noexcept {
+      count_.fetch_add(count, std::memory_order_relaxed);
+   }
+
    auto notify_awaitable_completed() noexcept {
       if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+         resume_awaiting();
+      }
+   }
+
+protected:
+   auto resume_awaiting() noexcept -> void {
+      if(push_ != nullptr) {
+         push_(queue_, awaiting_);
+      } else {
          awaiting_.resume();
       }
    }
 
 protected:
    std::atomic<std::size_t> count_;
-   std::coroutine_handle<>  awaiting_;
+   schedule_node awaiting_;
+   void* queue_{};
+   void (*push_)(void*, schedule_node&) noexcept {};
 };
 
 } E_CORO_NS_END
@@ -7,8 +7,10 @@
 
 #include <e-coro/e_coro_ns.h>
 #include <e-coro/core/detail/when_all_counter.h>
+#include <e-coro/scheduler/schedule_node.h>
 #include <coroutine>
 #include <tuple>
+#include <utility>
 
 E_CORO_NS_BEGIN namespace detail {
 
@@ -65,6 +67,21 @@ public:
       return awaiter{ *this };
    }
 
+   // the awaiting coroutine is pushed onto queue once all are done,
+   // rather than resumed by the last child inline:
+   //    co_await when_all_ready(a, b).resume_via(run_queue);
+   template<schedule_queue_concept Q>
+   auto resume_via(Q& queue) & noexcept -> when_all_ready_awaitable& {
+      counter_.resume_via(queue);
+      return *this;
+   }
+
+   template<schedule_queue_concept Q>
+   auto resume_via(Q& queue) && noexcept -> when_all_ready_awaitable&& {
+      counter_.resume_via(queue);
+      return std::move(*this);
+   }
+
 private:
    auto is_ready() const noexcept {
       return counter_.is_ready();
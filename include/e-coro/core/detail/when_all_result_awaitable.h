@@ -0,0 +1,170 @@
+#ifndef E_CORO_WHEN_ALL_RESULT_AWAITABLE_H
+#define E_CORO_WHEN_ALL_RESULT_AWAITABLE_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/core/detail/when_all_counter.h>
+#include <e-coro/core/detail/when_all_task.h>
+#include <e-coro/core/result.h>
+#include <atomic>
+#include <coroutine>
+#include <tuple>
+
+E_CORO_NS_BEGIN namespace detail {
+
+struct when_all_result_counter : when_all_counter {
+   using when_all_counter::when_all_counter;
+
+   template<typename R>
+   auto on_result(const R& result) noexcept {
+      if(!result.has_value()) {
+         failed_.store(true, std::memory_order_release);
+      }
+   }
+
+   auto has_failed() const noexcept -> bool {
+      return failed_.load(std::memory_order_acquire);
+   }
+
+private:
+   std::atomic<bool> failed_{false};
+};
+
+template<typename T>
+using non_void_t = std::conditional_t<std::is_void_v<T>, void_value, T>;
+
+template<typename TASK_CONTAINER>
+struct when_all_result_awaitable;
+
+template<typename ... TASKS>
+struct when_all_result_awaitable<std::tuple<TASKS...>> {
+   static_assert(sizeof...(TASKS) > 0);
+
+private:
+   template<typename TASK>
+   using child_result_t = typename TASK::promise_type::value_type;
+
+   using error_type = typename child_result_t<std::tuple_element_t<0, std::tuple<TASKS...>>>::error_type;
+   static_assert((std::is_same_v<typename child_result_t<TASKS>::error_type, error_type> && ...),
+      "all awaitables should fail with the same error type");
+
+public:
+   using result_type = result<std::tuple<non_void_t<typename child_result_t<TASKS>::value_type>...>, error_type>;
+
+   explicit when_all_result_awaitable(std::tuple<TASKS...>&& tasks)
+      : counter_{sizeof...(TASKS)}
+      , tasks_{std::move(tasks)}
+   {}
+
+private:
+   struct awaiter_base {
+      explicit awaiter_base(when_all_result_awaitable& awaitable) noexcept
+         : self_(awaitable)
+      {}
+
+      auto await_ready() const noexcept {
+         return self_.is_ready();
+      }
+
+      // try_await will return true if there are still tasks.
+      auto await_suspend(std::coroutine_handle<> awaiting) noexcept -> bool {
+         return self_.try_await(awaiting);
+      }
+
+      when_all_result_awaitable& self_;
+   };
+
+public:
+   auto operator co_await() & noexcept {
+      struct awaiter : awaiter_base {
+         using awaiter_base::awaiter_base;
+         auto await_resume() noexcept -> result_type {
+            return awaiter_base::self_.template collect<false>(std::index_sequence_for<TASKS...>{});
+         }
+      };
+      return awaiter{ *this };
+   }
+
+   auto operator co_await() && noexcept {
+      struct awaiter : awaiter_base {
+         using awaiter_base::awaiter_base;
+         auto await_resume() noexcept -> result_type {
+            return awaiter_base::self_.template collect<true>(std::index_sequence_for<TASKS...>{});
+         }
+      };
+      return awaiter{ *this };
+   }
+
+private:
+   auto is_ready() const noexcept {
+      return counter_.is_ready();
+   }
+
+   template<std::size_t I>
+   inline auto start_task() noexcept {
+      // someone has failed, no need to start the rest.
+      if(counter_.has_failed()) {
+         counter_.notify_awaitable_completed();
+      } else {
+         ++started_;
+         std::get<I>(tasks_).start(counter_);
+      }
+   }
+
+   template<std::size_t... I>
+   inline auto start_tasks(std::integer_sequence<std::size_t, I...>) noexcept {
+      (start_task<I>(), ...);
+   }
+
+   auto try_await(std::coroutine_handle<> awaiting) noexcept -> bool {
+      start_tasks(std::index_sequence_for<TASKS...>{});
+      return counter_.try_await(awaiting);
+   }
+
+   template<bool MOVE, std::size_t I>
+   auto child_result() noexcept -> decltype(auto) {
+      if constexpr(MOVE) {
+         return std::move(std::get<I>(tasks_)).result();
+      } else {
+         return std::get<I>(tasks_).result();
+      }
+   }
+
+   template<bool MOVE, std::size_t I>
+   auto child_value() noexcept -> decltype(auto) {
+      decltype(auto) result = child_result<MOVE, I>();
+      if constexpr(std::is_void_v<typename std::remove_reference_t<decltype(result)>::value_type>) {
+         return void_value{};
+      } else {
+         return std::forward<decltype(result)>(result).value();
+      }
+   }
+
+   template<bool MOVE, std::size_t... I>
+   auto collect(std::integer_sequence<std::size_t, I...>) noexcept -> result_type {
+      // only those started could have failed, and the first one wins.
+      error_type* error = nullptr;
+      ((error == nullptr && I < started_ && !child_result<false, I>().has_value()
+          ? (void)(error = std::addressof(child_result<false, I>().error()))
+          : (void)0), ...);
+
+      if(error != nullptr) {
+         if constexpr(MOVE) {
+            return unexpected<error_type>{std::move(*error)};
+         } else {
+            return unexpected<error_type>{*error};
+         }
+      }
+
+      return std::tuple<non_void_t<typename child_result_t<TASKS>::value_type>...>{
+         child_value<MOVE, I>()...};
+   }
+
+private:
+   when_all_result_counter counter_;
+   std::tuple<TASKS...>    tasks_;
+   std::size_t             started_{0};
+};
+
+} E_CORO_NS_END
+
+#endif //E_CORO_WHEN_ALL_RESULT_AWAITABLE_H
@@ -7,6 +7,8 @@
 
 #include <e-coro/core/detail/when_all_counter.h>
 #include <e-coro/core/awaitable_trait.h>
+#include <e-coro/trace/trace.h>
+#include <e-coro/debug/frame_stats.h>
 #include <cstddef>
 #include <atomic>
 #include <coroutine>
@@ -17,25 +19,31 @@ E_CORO_NS_BEGIN namespace detail {
 template<typename C>
 struct when_all_ready_awaitable;
 
-template<typename R>
+template<typename C>
+struct when_all_result_awaitable;
+
+template<typename R, typename COUNTER = when_all_counter>
 struct when_all_task;
 
-template<typename R>
-struct when_all_task_promise final {
-   using handle_type = std::coroutine_handle<when_all_task_promise<R>>;
+template<typename R, typename COUNTER = when_all_counter>
+struct when_all_task_promise final : trace_hooks, frame_stats_hooks {
+   using handle_type = std::coroutine_handle<when_all_task_promise<R, COUNTER>>;
+   using value_type = std::remove_reference_t<R>;
+   using reference_type = R&&;
 
    auto get_return_object() noexcept {
       return handle_type::from_promise(*this);
    }
 
    auto initial_suspend() noexcept {
-      return std::suspend_always{};
+      return trace_initial_suspend();
    }
 
    auto final_suspend() noexcept {
       struct completion_notifier {
          bool await_ready() const noexcept { return false; }
          void await_suspend(handle_type self) const noexcept {
+            self.promise().on_complete();
             self.promise().counter_->notify_awaitable_completed();
          }
          void await_resume() const noexcept {}
@@ -43,12 +51,15 @@ struct when_all_task_promise final {
       return completion_notifier{};
    }
 
-   auto yield_value(R&& result) noexcept {
+   auto yield_value(reference_type result) noexcept {
       result_ = std::addressof(result);
+      if constexpr(requires { counter_->on_result(*result_); }) {
+         counter_->on_result(*result_);
+      }
       return final_suspend();
    }
 
-   auto start(when_all_counter& counter) noexcept {
+   auto start(COUNTER& counter) noexcept {
       counter_ = &counter;
       handle_type::from_promise(*this).resume();
    }
@@ -58,30 +69,31 @@ struct when_all_task_promise final {
    }
 
    auto result() && -> R&& {
-      return std::move(*result_);
+      return static_cast<reference_type>(*result_);
    }
 
 private:
-   when_all_counter* counter_;
-   R result_;
+   COUNTER* counter_;
+   value_type* result_;
 };
 
-template<>
-struct when_all_task_promise<void> final {
-   using handle_type = std::coroutine_handle<when_all_task_promise<void>>;
+template<typename COUNTER>
+struct when_all_task_promise<void, COUNTER> final : trace_hooks, frame_stats_hooks {
+   using handle_type = std::coroutine_handle<when_all_task_promise<void, COUNTER>>;
 
    auto get_return_object() noexcept {
       return handle_type::from_promise(*this);
    }
 
    auto initial_suspend() noexcept {
-      return std::suspend_always{};
+      return trace_initial_suspend();
    }
 
    auto final_suspend() noexcept {
       struct completion_notifier {
          bool await_ready() const noexcept { return false; }
          void await_suspend(handle_type self) const noexcept {
+            self.promise().on_complete();
             self.promise().counter_->notify_awaitable_completed();
          }
          void await_resume() const noexcept {}
@@ -91,7 +103,7 @@ struct when_all_task_promise<void> final {
 
    void return_void() noexcept {}
 
-   void start(when_all_counter& counter) noexcept {
+   void start(COUNTER& counter) noexcept {
       counter_ = &counter;
       handle_type::from_promise(*this).resume();
    }
@@ -99,14 +111,14 @@ struct when_all_task_promise<void> final {
    void result() {}
 
 private:
-   when_all_counter* counter_;
+   COUNTER* counter_;
 };
 
 struct void_value {};
 
-template<typename R>
+template<typename R, typename COUNTER>
 struct when_all_task final {
-   using promise_type = when_all_task_promise<R>;
+   using promise_type = when_all_task_promise<R, COUNTER>;
    using handle_type = typename promise_type::handle_type;
 
    when_all_task(handle_type self) noexcept
@@ -150,9 +162,12 @@ struct when_all_task final {
 
 private:
    template<typename TASK_CONTAINER>
-   friend class when_all_ready_awaitable;
+   friend struct when_all_ready_awaitable;
+
+   template<typename TASK_CONTAINER>
+   friend struct when_all_result_awaitable;
 
-   void start(when_all_counter& counter) noexcept {
+   void start(COUNTER& counter) noexcept {
       self_.promise().start(counter);
    }
 
@@ -160,13 +175,13 @@ private:
    handle_type self_;
 };
 
-template<void_awaitable T>
-auto make_when_all_task(T awaitable) -> when_all_task<await_result_t<T>> {
+template<typename COUNTER = when_all_counter, void_awaitable T>
+auto make_when_all_task(T awaitable) -> when_all_task<void, COUNTER> {
    co_await static_cast<T&&>(awaitable);
 }
 
-template<non_void_awaitable T>
-auto make_when_all_task(T awaitable) -> when_all_task<void> {
+template<typename COUNTER = when_all_counter, non_void_awaitable T>
+auto make_when_all_task(T awaitable) -> when_all_task<await_result_t<T>, COUNTER> {
    co_yield co_await static_cast<T&&>(awaitable);
 }
 
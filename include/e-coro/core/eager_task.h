@@ -0,0 +1,238 @@
+#ifndef E_CORO_EAGER_TASK_H
+#define E_CORO_EAGER_TASK_H
+
+#include <e-coro/core/awaitable_trait.h>
+#include <e-coro/core/task.h>
+#include <atomic>
+#include <coroutine>
+#include <concepts>
+#include <optional>
+
+E_CORO_NS_BEGIN
+
+template<typename T> struct eager_task;
+
+namespace detail {
+
+   /////////////////////////////////////////////////////////////////////////
+   // state_ is the handshake between the coroutine and its awaiter:
+   //    nullptr       : running, nobody is waiting.
+   //    caller        : running, caller is suspended waiting for the result.
+   //    this          : completed, the result is ready.
+   // whoever comes second (the awaiter, or the final_suspend) does the job.
+   /////////////////////////////////////////////////////////////////////////
+   struct eager_task_promise_base {
+      friend struct final_awaitable;
+      struct final_awaitable {
+         auto await_ready() const noexcept { return false; }
+
+         template<std::derived_from<eager_task_promise_base> P>
+         auto await_suspend(std::coroutine_handle<P> self) noexcept -> std::coroutine_handle<> {
+            auto& promise = self.promise();
+            void* caller = promise.state_.exchange(promise.completed_state(), std::memory_order_acq_rel);
+            // no one is waiting yet, the result will be picked up later.
+            if(caller == nullptr) return std::noop_coroutine();
+            return std::coroutine_handle<>::from_address(caller);
+         }
+
+         auto await_resume() noexcept {}
+      };
+
+   public:
+      // unlike task, start running right away.
+      auto initial_suspend() noexcept {
+         return std::suspend_never{};
+      }
+
+      auto final_suspend() noexcept {
+         return final_awaitable{};
+      }
+
+      auto is_ready() const noexcept -> bool {
+         return state_.load(std::memory_order_acquire) == completed_state();
+      }
+
+      // return false if it's already completed, so that the caller
+      // should not be suspended.
+      auto try_await(std::coroutine_handle<> caller) noexcept -> bool {
+         void* state = nullptr;
+         return state_.compare_exchange_strong(
+            state,
+            caller.address(),
+            std::memory_order_release,
+            std::memory_order_acquire);
+      }
+
+   private:
+      auto completed_state() const noexcept -> void* {
+         return const_cast<eager_task_promise_base*>(this);
+      }
+
+   private:
+      std::atomic<void*> state_{nullptr};
+   };
+
+   template<typename T>
+   struct eager_task_promise final : eager_task_promise_base {
+      template<std::convertible_to<T> R>
+      auto return_value(R&& value) noexcept {
+         value_.emplace(std::forward<R>(value));
+      }
+
+      auto get_return_object() noexcept -> eager_task<T>;
+
+      auto result() & noexcept -> T& {
+         return *value_;
+      }
+
+      auto result() && noexcept -> T&& {
+         return std::move(*value_);
+      }
+
+   private:
+      std::optional<T> value_;
+   };
+
+   template<>
+   struct eager_task_promise<void> final : eager_task_promise_base {
+      auto return_void() noexcept {}
+      auto get_return_object() noexcept -> eager_task<void>;
+      auto result() noexcept {}
+   };
+
+   template<typename T>
+   struct eager_task_promise<T&> final : eager_task_promise_base {
+      auto get_return_object() noexcept -> eager_task<T&>;
+
+      auto return_value(T& value) noexcept {
+         value_ = std::addressof(value);
+      }
+
+      auto result() noexcept -> T& {
+         return *value_;
+      }
+
+   private:
+      T* value_;
+   };
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// eager_task starts running as soon as it's created, and keeps its result
+// in the frame until someone awaits it, so that independent requests could
+// be overlapped without any when_all_ready wrapper:
+//
+//    auto a = fetch_eagerly(key1);
+//    auto b = fetch_eagerly(key2);
+//    co_return co_await a + co_await b;
+//
+// At most one awaiter is allowed. the coroutine could complete on any
+// thread, the awaiter is resumed on whichever thread completes it. It's
+// the owner's duty not to destroy it while the body is still running.
+/////////////////////////////////////////////////////////////////////////////
+template <typename T = void>
+struct [[nodiscard("it will be destroyed automatically otherwise")]] eager_task {
+   using promise_type = detail::eager_task_promise<T>;
+
+private:
+   using handle_type = std::coroutine_handle<promise_type>;
+   struct awaitable_base {
+      awaitable_base(handle_type self) noexcept
+         : self_{self} {}
+
+      auto await_ready() const noexcept {
+         return !self_ || self_.promise().is_ready();
+      }
+
+      auto await_suspend(std::coroutine_handle<> caller) noexcept -> bool {
+         // if i'm done in between, caller should go on without suspending.
+         return self_.promise().try_await(caller);
+      }
+
+   protected:
+      handle_type self_;
+   };
+
+public:
+   eager_task() = default;
+
+   explicit eager_task(handle_type handle) noexcept
+      : self_{handle}
+   {}
+
+   eager_task(eager_task&& rhs) noexcept
+      : self_{std::exchange(rhs.self_, nullptr)}
+   {}
+
+   eager_task(eager_task const&) noexcept = delete;
+   eager_task& operator=(eager_task const&) noexcept = delete;
+
+   auto operator=(eager_task&& rhs) noexcept -> eager_task& {
+      std::swap(rhs.self_, self_);
+      return *this;
+   }
+
+   ~eager_task() noexcept {
+      if(self_) self_.destroy();
+   }
+
+   // caller awaits me, and i'm a lvalue-reference
+   auto operator co_await() const& noexcept {
+      struct awaitable : awaitable_base {
+         using awaitable_base::awaitable_base;
+         auto await_resume() noexcept -> decltype(auto) {
+            return awaitable_base::self_.promise().result();
+         }
+      };
+      return awaitable{ self_ };
+   }
+
+   // caller awaits me, and i'm a rvalue-reference
+   auto operator co_await() const&& noexcept {
+      struct awaitable : awaitable_base {
+         using awaitable_base::awaitable_base;
+         auto await_resume() noexcept -> decltype(auto) {
+            return std::move(awaitable_base::self_.promise()).result();
+         }
+      };
+      return awaitable{ self_ };
+   }
+
+   auto is_ready() const noexcept -> bool {
+      return !self_ || self_.promise().is_ready();
+   }
+
+private:
+   handle_type self_;
+};
+
+namespace detail {
+   template<typename T>
+   inline auto eager_task_promise<T>::get_return_object() noexcept -> eager_task<T> {
+      return eager_task<T>{ std::coroutine_handle<eager_task_promise>::from_promise(*this) };
+   }
+
+   inline auto eager_task_promise<void>::get_return_object() noexcept -> eager_task<void> {
+      return eager_task<void>{ std::coroutine_handle<eager_task_promise>::from_promise(*this) };
+   }
+
+   template<typename T>
+   inline auto eager_task_promise<T&>::get_return_object() noexcept -> eager_task<T&> {
+      return eager_task<T&>{ std::coroutine_handle<eager_task_promise>::from_promise(*this) };
+   }
+}
+
+// start a lazy awaitable (a task<T> for instance) right now.
+template<void_awaitable A>
+auto make_eager_task(A awaitable) -> eager_task<> {
+   co_await static_cast<A&&>(awaitable);
+}
+
+template<non_void_awaitable A>
+auto make_eager_task(A awaitable) -> eager_task<detail::remove_rvalue_reference_t<await_result_t<A>>> {
+   co_return co_await static_cast<A&&>(awaitable);
+}
+
+E_CORO_NS_END
+
+#endif //E_CORO_EAGER_TASK_H
@@ -9,6 +9,8 @@
 #include <coroutine>
 #include <concepts>
 #include <functional>
+#include <optional>
+#include <utility>
 
 E_CORO_NS_BEGIN
 
@@ -57,6 +59,43 @@ namespace detail {
    template<typename A, typename F>
    concept constructible_to = std::constructible_from<F, A>;
 
+   /////////////////////////////////////////////////////////////////////////
+   // g . f, so that a pipeline of fmap is applied by a single awaiter over
+   // the original awaitable, rather than an awaiter nested per stage.
+   /////////////////////////////////////////////////////////////////////////
+   template<typename F, typename G>
+   struct fmap_composed {
+      template<typename ... ARGS>
+      auto operator()(ARGS&& ... args) & -> decltype(auto) {
+         return invoke(f_, g_, std::forward<ARGS>(args)...);
+      }
+
+      template<typename ... ARGS>
+      auto operator()(ARGS&& ... args) const& -> decltype(auto) {
+         return invoke(f_, g_, std::forward<ARGS>(args)...);
+      }
+
+      template<typename ... ARGS>
+      auto operator()(ARGS&& ... args) && -> decltype(auto) {
+         return invoke(std::move(f_), std::move(g_), std::forward<ARGS>(args)...);
+      }
+
+      [[no_unique_address]] F f_;
+      [[no_unique_address]] G g_;
+
+   private:
+      template<typename FF, typename GG, typename ... ARGS>
+      static auto invoke(FF&& f, GG&& g, ARGS&& ... args) -> decltype(auto) {
+         if constexpr(std::is_void_v<std::invoke_result_t<FF, ARGS...>>) {
+            std::invoke(std::forward<FF>(f), std::forward<ARGS>(args)...);
+            return std::invoke(std::forward<GG>(g));
+         } else {
+            return std::invoke(std::forward<GG>(g),
+                               std::invoke(std::forward<FF>(f), std::forward<ARGS>(args)...));
+         }
+      }
+   };
+
    template<typename F, typename A>
    struct fmap_awaitable final {
       static_assert(!std::is_reference_v<F>);
@@ -82,10 +121,29 @@ namespace detail {
          return fmap_awaiter<F&&, A&&>(std::move(func_), std::move(awaitable_));
       }
 
+      // fmap(g, fmap(f, a)) => fmap(g . f, a)
+      template<typename G>
+      auto fuse(G&& g) const& {
+         using composed = fmap_composed<F, std::decay_t<G>>;
+         return fmap_awaitable<composed, A>{composed{func_, std::forward<G>(g)}, awaitable_};
+      }
+
+      template<typename G>
+      auto fuse(G&& g) && {
+         using composed = fmap_composed<F, std::decay_t<G>>;
+         return fmap_awaitable<composed, A>{composed{std::move(func_), std::forward<G>(g)}, std::move(awaitable_)};
+      }
+
    private:
-      F func_;
+      [[no_unique_address]] F func_;
       A awaitable_;
    };
+
+   template<typename T>
+   struct is_fmap_awaitable : std::false_type {};
+
+   template<typename F, typename A>
+   struct is_fmap_awaitable<fmap_awaitable<F, A>> : std::true_type {};
 }
 
 template<typename F, awaitable_concept A>
@@ -108,19 +166,77 @@ inline auto fmap(F&& func) -> fmap_transform<F> {
    return fmap_transform<F>{ std::forward<F>(func) };
 }
 
+namespace detail {
+   template<typename F, typename T>
+   inline auto fmap_pipe(F&& func, T&& value) {
+      if constexpr(is_fmap_awaitable<std::remove_cvref_t<T>>::value) {
+         return std::forward<T>(value).fuse(std::forward<F>(func));
+      } else {
+         return fmap(std::forward<F>(func), std::forward<T>(value));
+      }
+   }
+}
+
 template<typename T, typename F>
 inline auto operator|(T&& value, fmap_transform<F>&& transform) -> decltype(auto) {
-   return fmap(std::forward<F>(transform.func_), std::forward<T>(value));
+   return detail::fmap_pipe(std::forward<F>(transform.func_), std::forward<T>(value));
 }
 
 template<typename T, typename F>
 inline auto operator|(T&& value, const fmap_transform<F>& transform) -> decltype(auto) {
-   return fmap(transform.func_, std::forward<T>(value));
+   return detail::fmap_pipe(transform.func_, std::forward<T>(value));
 }
 
 template<typename T, typename FUNC>
 inline auto operator|(T&& value, fmap_transform<FUNC>& transform) -> decltype(auto) {
-   return fmap(transform.func_, std::forward<T>(value));
+   return detail::fmap_pipe(transform.func_, std::forward<T>(value));
+}
+
+namespace detail {
+   // a value from an r-value is passed on by value, otherwise it would
+   // dangle once the stage is fused with the next one.
+   template<typename V>
+   using pass_on_t = std::conditional_t<std::is_lvalue_reference_v<V>, V, std::remove_cvref_t<V>>;
+
+   template<typename F>
+   struct tap_fn {
+      auto operator()() const -> void {
+         std::invoke(func_);
+      }
+
+      template<typename V>
+      auto operator()(V&& value) const -> pass_on_t<V> {
+         std::invoke(func_, std::as_const(value));
+         return std::forward<V>(value);
+      }
+
+      [[no_unique_address]] F func_;
+   };
+
+   template<typename P>
+   struct filter_fn {
+      template<typename V>
+      auto operator()(V&& value) const -> std::optional<std::remove_cvref_t<V>> {
+         if(std::invoke(pred_, std::as_const(value))) {
+            return std::forward<V>(value);
+         }
+         return std::nullopt;
+      }
+
+      [[no_unique_address]] P pred_;
+   };
+}
+
+// awaitable | tap(f): f sees the value, which is passed on untouched.
+template<typename F>
+inline auto tap(F&& func) {
+   return fmap(detail::tap_fn<std::decay_t<F>>{std::forward<F>(func)});
+}
+
+// awaitable | filter(p): gives std::optional of the value, empty if p fails.
+template<typename P>
+inline auto filter(P&& pred) {
+   return fmap(detail::filter_fn<std::decay_t<P>>{std::forward<P>(pred)});
 }
 
 E_CORO_NS_END
@@ -0,0 +1,228 @@
+#ifndef E_CORO_RESULT_H
+#define E_CORO_RESULT_H
+
+#include <e-coro/e_coro_ns.h>
+#include <concepts>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+E_CORO_NS_BEGIN
+
+/////////////////////////////////////////////////////////////////////////////
+// A small std::expected alike, since we are built with -fno-exceptions and
+// C++ 20. accessing value() of a failed result (or error() of a succeeded
+// one) is undefined, check has_value() first.
+/////////////////////////////////////////////////////////////////////////////
+template<typename E>
+struct unexpected {
+   template<typename G = E>
+   requires std::constructible_from<E, G>
+   explicit unexpected(G&& error)
+      : error_(std::forward<G>(error))
+   {}
+
+   auto error() & noexcept -> E& { return error_; }
+   auto error() const& noexcept -> const E& { return error_; }
+   auto error() && noexcept -> E&& { return std::move(error_); }
+
+private:
+   E error_;
+};
+
+template<typename E>
+unexpected(E) -> unexpected<E>;
+
+template<typename T, typename E>
+struct result;
+
+namespace detail {
+   template<typename T>
+   struct is_unexpected : std::false_type {};
+
+   template<typename E>
+   struct is_unexpected<unexpected<E>> : std::true_type {};
+
+   template<typename T>
+   struct is_result : std::false_type {};
+
+   template<typename T, typename E>
+   struct is_result<result<T, E>> : std::true_type {};
+}
+
+template<typename T>
+concept result_concept = detail::is_result<std::remove_cvref_t<T>>::value;
+
+template<typename T, typename E>
+struct [[nodiscard]] result {
+   static_assert(!std::is_reference_v<T>);
+   static_assert(!std::is_reference_v<E>);
+
+   using value_type = T;
+   using error_type = E;
+
+   template<typename U = T>
+   requires (!std::same_as<std::remove_cvref_t<U>, result> &&
+             !detail::is_unexpected<std::remove_cvref_t<U>>::value &&
+             std::constructible_from<T, U>)
+   result(U&& value)
+      : has_value_{true} {
+      new (std::addressof(value_)) T(std::forward<U>(value));
+   }
+
+   template<typename G>
+   requires std::constructible_from<E, G&&>
+   result(unexpected<G>&& error)
+      : has_value_{false} {
+      new (std::addressof(error_)) E(std::move(error).error());
+   }
+
+   template<typename G>
+   requires std::constructible_from<E, const G&>
+   result(const unexpected<G>& error)
+      : has_value_{false} {
+      new (std::addressof(error_)) E(error.error());
+   }
+
+   result(const result& rhs)
+      : has_value_{rhs.has_value_} {
+      if(has_value_) new (std::addressof(value_)) T(rhs.value_);
+      else           new (std::addressof(error_)) E(rhs.error_);
+   }
+
+   result(result&& rhs) noexcept
+      : has_value_{rhs.has_value_} {
+      if(has_value_) new (std::addressof(value_)) T(std::move(rhs.value_));
+      else           new (std::addressof(error_)) E(std::move(rhs.error_));
+   }
+
+   auto operator=(const result& rhs) -> result& {
+      if(this != &rhs) {
+         destroy();
+         new (this) result(rhs);
+      }
+      return *this;
+   }
+
+   auto operator=(result&& rhs) noexcept -> result& {
+      if(this != &rhs) {
+         destroy();
+         new (this) result(std::move(rhs));
+      }
+      return *this;
+   }
+
+   ~result() noexcept {
+      destroy();
+   }
+
+   auto has_value() const noexcept -> bool { return has_value_; }
+   explicit operator bool() const noexcept { return has_value_; }
+
+   auto value() & noexcept -> T& { return value_; }
+   auto value() const& noexcept -> const T& { return value_; }
+   auto value() && noexcept -> T&& { return std::move(value_); }
+
+   auto error() & noexcept -> E& { return error_; }
+   auto error() const& noexcept -> const E& { return error_; }
+   auto error() && noexcept -> E&& { return std::move(error_); }
+
+   auto operator*() & noexcept -> T& { return value_; }
+   auto operator*() const& noexcept -> const T& { return value_; }
+   auto operator*() && noexcept -> T&& { return std::move(value_); }
+
+   auto operator->() noexcept -> T* { return std::addressof(value_); }
+   auto operator->() const noexcept -> const T* { return std::addressof(value_); }
+
+private:
+   auto destroy() noexcept {
+      if(has_value_) value_.~T();
+      else           error_.~E();
+   }
+
+private:
+   union {
+      T value_;
+      E error_;
+   };
+   bool has_value_;
+};
+
+template<typename E>
+struct [[nodiscard]] result<void, E> {
+   static_assert(!std::is_reference_v<E>);
+
+   using value_type = void;
+   using error_type = E;
+
+   result() noexcept : has_value_{true} {}
+
+   template<typename G>
+   requires std::constructible_from<E, G&&>
+   result(unexpected<G>&& error)
+      : has_value_{false} {
+      new (std::addressof(error_)) E(std::move(error).error());
+   }
+
+   template<typename G>
+   requires std::constructible_from<E, const G&>
+   result(const unexpected<G>& error)
+      : has_value_{false} {
+      new (std::addressof(error_)) E(error.error());
+   }
+
+   result(const result& rhs)
+      : has_value_{rhs.has_value_} {
+      if(!has_value_) new (std::addressof(error_)) E(rhs.error_);
+   }
+
+   result(result&& rhs) noexcept
+      : has_value_{rhs.has_value_} {
+      if(!has_value_) new (std::addressof(error_)) E(std::move(rhs.error_));
+   }
+
+   auto operator=(const result& rhs) -> result& {
+      if(this != &rhs) {
+         destroy();
+         new (this) result(rhs);
+      }
+      return *this;
+   }
+
+   auto operator=(result&& rhs) noexcept -> result& {
+      if(this != &rhs) {
+         destroy();
+         new (this) result(std::move(rhs));
+      }
+      return *this;
+   }
+
+   ~result() noexcept {
+      destroy();
+   }
+
+   auto has_value() const noexcept -> bool { return has_value_; }
+   explicit operator bool() const noexcept { return has_value_; }
+
+   auto value() const noexcept {}
+
+   auto error() & noexcept -> E& { return error_; }
+   auto error() const& noexcept -> const E& { return error_; }
+   auto error() && noexcept -> E&& { return std::move(error_); }
+
+private:
+   auto destroy() noexcept {
+      if(!has_value_) error_.~E();
+   }
+
+private:
+   union {
+      E error_;
+   };
+   bool has_value_;
+};
+
+E_CORO_NS_END
+
+#endif //E_CORO_RESULT_H
@@ -6,6 +6,7 @@
 #define E_CORO_SINGLE_CONSUMER_EVENT_H
 
 #include <e-coro/e_coro_ns.h>
+#include <e-coro/scheduler/schedule_node.h>
 #include <atomic>
 #include <coroutine>
 
@@ -23,7 +24,17 @@ struct single_consumer_event {
    auto set() {
       const state old_state = state_.exchange(state::set, std::memory_order_acq_rel);
       if (old_state == state::not_set_consumer_waiting) {
-         self_.resume();
+         waiter_->resume();
+      }
+   }
+
+   // hand the waiting consumer, if any, over to queue rather than resuming
+   // it right here.
+   template<schedule_queue_concept Q>
+   auto set(Q& queue) {
+      const state old_state = state_.exchange(state::set, std::memory_order_acq_rel);
+      if (old_state == state::not_set_consumer_waiting) {
+         queue.push(*waiter_);
       }
    }
 
@@ -41,7 +52,8 @@ struct single_consumer_event {
          }
 
          auto await_suspend(std::coroutine_handle<> self) {
-            event_.self_ = self;
+            node_.handle_ = self;
+            event_.waiter_ = &node_;
             state old_state = state::not_set;
             return event_.state_.compare_exchange_strong(
                old_state,
@@ -54,6 +66,7 @@ struct single_consumer_event {
 
       private:
          single_consumer_event& event_;
+         schedule_node node_;
       };
 
       return awaiter{ *this };
@@ -68,7 +81,8 @@ private:
    };
 
    std::atomic<state> state_;
-   std::coroutine_handle<> self_;
+   // in the awaiter of the consumer.
+   schedule_node* waiter_{};
 };
 
 E_CORO_NS_END
@@ -7,6 +7,8 @@
 
 #include <e-coro/e_coro_ns.h>
 #include <e-coro/core/awaitable_trait.h>
+#include <e-coro/trace/trace.h>
+#include <e-coro/debug/frame_stats.h>
 #include <coroutine>
 #include <memory>
 #include <future>
@@ -20,17 +22,18 @@ namespace detail {
    using sync_wait_notifier = std::promise<void>;
 
    template<typename P>
-   struct sync_wait_task_promise_base {
+   struct sync_wait_task_promise_base : trace_hooks, frame_stats_hooks {
       using handle_type = std::coroutine_handle<P>;
 
       auto initial_suspend() noexcept {
-         return std::suspend_always{};
+         return trace_initial_suspend();
       }
 
       auto final_suspend() noexcept {
          struct completion_notifier {
             bool await_ready() const noexcept { return false; }
             void await_suspend(handle_type self) const noexcept {
+               self.promise().on_complete();
                self.promise().notifier_->set_value();
             }
             void await_resume() noexcept {}
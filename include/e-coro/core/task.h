@@ -6,9 +6,19 @@
 #define E_CORO_TASK_H
 
 #include <e-coro/core/awaitable_trait.h>
+#include <e-coro/core/result.h>
+#include <e-coro/trace/trace.h>
+#include <e-coro/debug/async_stack.h>
+#include <e-coro/debug/task_stats.h>
+#include <e-coro/debug/frame_stats.h>
+#include <e-coro/core/detail/promise_hooks.h>
 #include <coroutine>
 #include <concepts>
-#include <optional>
+#include <cstdint>
+#include <memory>
+#if E_CORO_TRACING || E_CORO_ASYNC_STACK || E_CORO_TASK_STATS
+#include <source_location>
+#endif
 
 E_CORO_NS_BEGIN
 
@@ -16,7 +26,7 @@ template<typename T> struct task;
 
 namespace detail {
 
-   struct task_promise_base {
+   struct task_promise_base : trace_hooks, async_stack_hooks, task_stats_hooks, frame_stats_hooks {
       friend struct final_awaitable;
       struct final_awaitable {
          auto await_ready() const noexcept { return false; }
@@ -24,53 +34,147 @@ namespace detail {
          template<std::derived_from<task_promise_base> P>
          auto await_suspend(std::coroutine_handle<P> self) noexcept {
             // i'm done here, return the execution to caller.
-            return self.promise().caller_;
+            return complete(self.promise());
          }
 
          auto await_resume() noexcept {}
       };
 
    public:
+      explicit task_promise_base(task_site site) noexcept
+         : task_stats_hooks{site}
+      {}
+
+#if E_CORO_TRACING || E_CORO_ASYNC_STACK || E_CORO_TASK_STATS
+      auto initial_suspend() noexcept {
+         return hooked_initial_suspend<task_promise_base>{{}, this};
+      }
+
+      // remember where i'm suspended, and let the hooks know.
+      template<awaitable_concept A>
+      auto await_transform(A&& awaitable, std::source_location where = std::source_location::current()) {
+         record_location(where);
+         return hook_awaiter(*this, std::forward<A>(awaitable));
+      }
+#else
       auto initial_suspend() noexcept {
          return std::suspend_always{};
       }
+#endif
+
+      auto on_start() noexcept -> void {
+         trace_hooks::on_start();
+         task_stats_hooks::on_start();
+      }
+
+      auto on_suspend() noexcept -> void {
+         trace_hooks::on_suspend();
+         task_stats_hooks::on_suspend();
+      }
+
+      auto on_resume() noexcept -> void {
+         trace_hooks::on_resume();
+         task_stats_hooks::on_resume();
+      }
+
+      auto on_suspend_cancelled() noexcept -> void {
+         trace_hooks::on_suspend_cancelled();
+         task_stats_hooks::on_suspend_cancelled();
+      }
+
+      auto on_complete() noexcept -> void {
+         trace_hooks::on_complete();
+         task_stats_hooks::on_complete();
+      }
 
       auto final_suspend() noexcept {
          return final_awaitable{};
       }
 
-      auto save_caller(std::coroutine_handle<> caller) noexcept {
-         caller_ = caller;
+      template<typename P>
+      auto save_caller(std::coroutine_handle<P> caller) noexcept {
+         caller_ = reinterpret_cast<std::uintptr_t>(caller.address()) | (caller_ & result_bit);
+         link_caller(caller);
+         started_by(caller);
+      }
+
+      auto continuation() const noexcept -> std::coroutine_handle<> {
+         return std::coroutine_handle<>::from_address(reinterpret_cast<void*>(caller_ & ~result_bit));
+      }
+
+   protected:
+      // let the hooks know i'm done, and give the one to go on with; at
+      // final_suspend, or as i'm short-circuited.
+      template<std::derived_from<task_promise_base> P>
+      static auto complete(P& promise) noexcept -> std::coroutine_handle<> {
+         promise.on_complete();
+         promise.unlink();
+         auto next = promise.continuation();
+         // unless an error is propagated past it.
+         if(next.address() == promise.task_promise_base::continuation().address()) {
+            promise.hand_off_to_caller();
+         }
+         return next;
+      }
+
+      ///////////////////////////////////////////////////////////////////////
+      // A result is stored right before the caller is resumed, thus they
+      // can't share the storage; but a frame is aligned to 2 at least, so
+      // the lowest bit of the caller is spare to tell if a result is
+      // stored, rather than an optional with a flag of its own, padded.
+      ///////////////////////////////////////////////////////////////////////
+      auto has_result() const noexcept -> bool {
+         return (caller_ & result_bit) != 0;
+      }
+
+      auto set_has_result() noexcept -> void {
+         caller_ |= result_bit;
       }
 
    private:
-      std::coroutine_handle<> caller_;
+      constexpr static std::uintptr_t result_bit = 1;
+      std::uintptr_t caller_{};
    };
 
    template<typename T>
    struct task_promise : task_promise_base {
+      explicit task_promise(task_site site = task_site{}) noexcept
+         : task_promise_base{site}
+      {}
+
+      ~task_promise() noexcept {
+         if constexpr(!std::is_trivially_destructible_v<T>) {
+            if(has_result()) value_.~T();
+         }
+      }
 
       template<std::convertible_to<T> R>
       auto return_value(R&& value) noexcept {
-         value_.template emplace<T>(std::forward<R>(value));
+         std::construct_at(std::addressof(value_), std::forward<R>(value));
+         set_has_result();
       }
 
       auto get_return_object() noexcept -> task<T>;
 
       auto result() & noexcept -> T& {
-         return *value_;
+         return value_;
       }
 
       auto result() && noexcept -> T&& {
-         return std::move(*value_);
+         return std::move(value_);
       }
 
    private:
-      std::optional<T> value_;
+      // only after return_value, when has_result().
+      union { T value_; };
    };
 
    template<>
    struct task_promise<void> final : task_promise_base {
+      explicit task_promise(task_site site = task_site{}) noexcept
+         : task_promise_base{site}
+      {}
+
       auto return_void() noexcept {}
       auto get_return_object() noexcept -> task<void>;
       auto result() noexcept {}
@@ -78,6 +182,10 @@ namespace detail {
 
    template<typename T>
    struct task_promise<T&> final : task_promise_base {
+      explicit task_promise(task_site site = task_site{}) noexcept
+         : task_promise_base{site}
+      {}
+
       task<T&> get_return_object() noexcept;
 
       auto return_value(T& value) noexcept {
@@ -91,6 +199,87 @@ namespace detail {
    private:
       T* m_value;
    };
+
+   /////////////////////////////////////////////////////////////////////////
+   // a task<result<T, E>> could be short-circuited by try_await: once an
+   // awaited result fails, the error is stored here and the caller of this
+   // task is resumed, the rest of the body is never executed.
+   /////////////////////////////////////////////////////////////////////////
+   template<typename T, typename E>
+   struct task_promise<result<T, E>> final : task_promise_base {
+      explicit task_promise(task_site site = task_site{}) noexcept
+         : task_promise_base{site}
+      {}
+
+      using value_type = E_CORO_NS::result<T, E>;
+
+      ~task_promise() noexcept {
+         if(has_result()) value_.~value_type();
+      }
+
+      auto return_value(value_type value) noexcept {
+         std::construct_at(std::addressof(value_), std::move(value));
+         set_has_result();
+      }
+
+      auto get_return_object() noexcept -> task<value_type>;
+
+      auto result() & noexcept -> value_type& {
+         return value_;
+      }
+
+      auto result() && noexcept -> value_type&& {
+         return std::move(value_);
+      }
+
+      // true once returned, or short-circuited.
+      auto is_completed() const noexcept -> bool {
+         return has_result();
+      }
+
+      // complete me with an error, and return the one to go on with.
+      template<typename G>
+      auto fail(G&& error) noexcept -> std::coroutine_handle<> {
+         std::construct_at(std::addressof(value_), unexpected<E>{std::forward<G>(error)});
+         set_has_result();
+         // i'm suspended, and resumed only to be done, as final_suspend is
+         // never reached.
+         on_resume();
+         return complete(*this);
+      }
+
+      // my caller is awaiting me by try_await, an error should be
+      // propagated to it rather than resuming it. the caller is known
+      // by the continuation already, only its type is to be kept.
+      template<typename P>
+      auto propagate_error_to(std::coroutine_handle<P>) noexcept {
+         propagate_ = [](void* caller, E&& error) noexcept {
+            return std::coroutine_handle<P>::from_address(caller).promise().fail(std::move(error));
+         };
+      }
+
+      auto continuation() noexcept -> std::coroutine_handle<> {
+         auto caller = task_promise_base::continuation();
+         if(propagate_ != nullptr && !value_.has_value()) {
+            return propagate_(caller.address(), std::move(value_).error());
+         }
+         return caller;
+      }
+
+   private:
+      // only after return_value or fail, when has_result().
+      union { value_type value_; };
+      std::coroutine_handle<> (*propagate_)(void*, E&&) noexcept {};
+   };
+
+   template<typename P>
+   inline auto is_task_completed(std::coroutine_handle<P> self) noexcept -> bool {
+      if constexpr(requires { self.promise().is_completed(); }) {
+         return self.promise().is_completed();
+      } else {
+         return self.done();
+      }
+   }
 }
 
 template <typename T = void>
@@ -104,10 +293,11 @@ private:
          : self_{self} {}
 
       auto await_ready() const noexcept {
-         return !self_ || self_.done();
+         return !self_ || detail::is_task_completed(self_);
       }
 
-      auto await_suspend(std::coroutine_handle<> caller) noexcept {
+      template<typename P>
+      auto await_suspend(std::coroutine_handle<P> caller) noexcept {
          // When caller awaits me, if I'm not done yet, caller will be suspended.
          // Save my caller so that it will be resumed after I'm done.
          self_.promise().save_caller(caller);
@@ -165,9 +355,15 @@ public:
    }
 
    auto is_ready() const noexcept -> bool {
-      return !self_ || self_.done();
+      return !self_ || detail::is_task_completed(self_);
    }
 
+#if E_CORO_ASYNC_STACK
+   auto async_frame() const noexcept -> const E_CORO_NS::async_frame* {
+      return async_frame_of(self_);
+   }
+#endif
+
 private:
    handle_type self_;
 };
@@ -187,6 +383,11 @@ namespace detail {
       return task<T&>{ std::coroutine_handle<task_promise>::from_promise(*this) };
    }
 
+   template<typename T, typename E>
+   inline auto task_promise<result<T, E>>::get_return_object() noexcept -> task<value_type> {
+      return task<value_type>{ std::coroutine_handle<task_promise>::from_promise(*this) };
+   }
+
    template<typename T>
    struct remove_rvalue_reference {
       using type = T;
@@ -0,0 +1,360 @@
+#ifndef E_CORO_THEN_H
+#define E_CORO_THEN_H
+
+#include <e-coro/core/awaitable_trait.h>
+#include <e-coro/core/fmap.h>
+#include <e-coro/core/result.h>
+#include <e-coro/core/detail/inline_driver.h>
+#include <e-coro/scheduler/scheduler_concept.h>
+#include <coroutine>
+#include <concepts>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <variant>
+
+E_CORO_NS_BEGIN
+
+namespace detail {
+   // whatever await_suspend returns, turn it into the one to transfer to.
+   template<typename AWAITER>
+   inline auto suspend_to(AWAITER& awaiter, std::coroutine_handle<> caller) noexcept
+   -> std::coroutine_handle<> {
+      using result_t = decltype(awaiter.await_suspend(caller));
+      if constexpr(std::is_void_v<result_t>) {
+         awaiter.await_suspend(caller);
+         return std::noop_coroutine();
+      } else if constexpr(std::is_same_v<result_t, bool>) {
+         return awaiter.await_suspend(caller) ? std::noop_coroutine() : caller;
+      } else {
+         return awaiter.await_suspend(caller);
+      }
+   }
+
+   // awaits an awaiter in place, its result is left to be taken later.
+   template<typename AWAITER>
+   struct awaiter_ref {
+      auto await_ready() -> bool {
+         return awaiter_.await_ready();
+      }
+
+      auto await_suspend(std::coroutine_handle<> caller) noexcept {
+         return suspend_to(awaiter_, caller);
+      }
+
+      auto await_resume() noexcept {}
+
+      AWAITER& awaiter_;
+   };
+
+   template<typename AWAITER>
+   awaiter_ref(AWAITER&) -> awaiter_ref<AWAITER>;
+
+   // an awaitable together with its awaiter, which might refer to it.
+   template<typename AWAITABLE>
+   struct awaiter_holder {
+      using awaiter_t = typename awaitable_traits<AWAITABLE&&>::awaiter_t;
+
+      template<typename FACTORY>
+      awaiter_holder(std::in_place_t, FACTORY&& factory)
+         : awaitable_{std::forward<FACTORY>(factory)()}
+         , awaiter_{get_awaiter(std::forward<AWAITABLE>(awaitable_))}
+      {}
+
+      awaiter_holder(awaiter_holder const&) = delete;
+      awaiter_holder& operator=(awaiter_holder const&) = delete;
+
+      auto awaiter() noexcept -> std::remove_reference_t<awaiter_t>& {
+         return awaiter_;
+      }
+
+   private:
+      AWAITABLE awaitable_;
+      awaiter_t awaiter_;
+   };
+
+   // an awaitable given as an lvalue is kept as a reference_wrapper.
+   template<typename T>
+   inline auto unwrap(T&& value) noexcept -> decltype(auto) {
+      if constexpr(!std::is_same_v<std::unwrap_reference_t<std::decay_t<T>>, std::decay_t<T>>) {
+         return value.get();
+      } else {
+         return std::forward<T>(value);
+      }
+   }
+
+   template<typename T>
+   using unwrap_t = decltype(unwrap(std::declval<T>()));
+
+   template<typename T>
+   using stored_awaitable_t = std::conditional_t<std::is_lvalue_reference_v<T>,
+      std::reference_wrapper<std::remove_reference_t<T>>, std::decay_t<T>>;
+
+   template<typename R>
+   using stored_value_t = std::conditional_t<
+      std::is_reference_v<R> || std::is_void_v<R>, std::monostate, std::optional<R>>;
+
+   /////////////////////////////////////////////////////////////////////////
+   // co_await f(co_await first), or alike, as a single awaiter. If first is
+   // ready right away, the next stage is awaited directly by the caller;
+   // otherwise a driver coroutine gets in between first's completion and
+   // the caller's resumption, whose frame is in the awaiter.
+   //
+   // A POLICY decides how the next stage is bound:
+   //    bind(first, next) -> bool      : emplace next, false if there's none.
+   //    resume(first, next) -> result  : the result of the whole.
+   /////////////////////////////////////////////////////////////////////////
+   template<template<typename, typename> class POLICY, typename F, typename A>
+   struct bind_awaiter {
+      using first_t = typename awaitable_traits<A&&>::awaiter_t;
+      using first_result_t = decltype(std::declval<std::remove_reference_t<first_t>&>().await_resume());
+      using policy_t = POLICY<F, first_result_t>;
+      using next_t = awaiter_holder<typename policy_t::next_awaitable_t>;
+
+      bind_awaiter(F&& func, A&& awaitable)
+         : policy_{std::forward<F>(func)}
+         , first_{get_awaiter(std::forward<A>(awaitable))}
+      {}
+
+      bind_awaiter(bind_awaiter const&) = delete;
+      bind_awaiter& operator=(bind_awaiter const&) = delete;
+
+      ~bind_awaiter() {
+         if(driver_) driver_.destroy();
+      }
+
+      auto await_ready() -> bool {
+         return first_.await_ready() && bind_next();
+      }
+
+      auto await_suspend(std::coroutine_handle<> caller) noexcept -> std::coroutine_handle<> {
+         if(next_) {
+            return suspend_to(next_->awaiter(), caller);
+         }
+         driver_ = drive(frame_, *this).handle_;
+         driver_.promise().context_ = caller.address();
+         driver_.promise().on_done_ = resume_caller;
+         return driver_;
+      }
+
+      auto await_resume() -> decltype(auto) {
+         return policy_.resume(first_, next_);
+      }
+
+   private:
+      // return true if there's nothing more to wait for.
+      auto bind_next() -> bool {
+         return !policy_.bind(first_, next_) || next_->awaiter().await_ready();
+      }
+
+      static auto drive(inline_frame&, bind_awaiter& self) -> inline_driver {
+         co_await awaiter_ref{self.first_};
+         if(!self.bind_next()) {
+            co_await awaiter_ref{self.next_->awaiter()};
+         }
+      }
+
+   private:
+      policy_t policy_;
+      first_t first_;
+      std::optional<next_t> next_;
+      std::coroutine_handle<inline_driver::promise_type> driver_;
+      inline_frame frame_;
+   };
+
+   template<template<typename, typename> class POLICY, typename F, typename A>
+   struct bind_awaitable final {
+      static_assert(!std::is_reference_v<F>);
+      static_assert(!std::is_reference_v<A>);
+
+      template<
+         constructible_to<F> F_ARG,
+         constructible_to<A> A_ARG>
+      explicit bind_awaitable(F_ARG&& func, A_ARG&& awaitable)
+         : func_{std::forward<F_ARG>(func)}
+         , awaitable_{std::forward<A_ARG>(awaitable)}
+      {}
+
+      auto operator co_await() const & {
+         return bind_awaiter<POLICY, const F&, unwrap_t<const A&>>(func_, unwrap(awaitable_));
+      }
+
+      auto operator co_await() & {
+         return bind_awaiter<POLICY, F&, unwrap_t<A&>>(func_, unwrap(awaitable_));
+      }
+
+      auto operator co_await() && {
+         return bind_awaiter<POLICY, F&&, unwrap_t<A&&>>(std::move(func_), unwrap(std::move(awaitable_)));
+      }
+
+   private:
+      [[no_unique_address]] F func_;
+      A awaitable_;
+   };
+
+   template<typename F, typename R>
+   struct then_policy {
+      using next_awaitable_t = typename std::conditional_t<std::is_void_v<R>,
+         std::invoke_result<F>, std::invoke_result<F, R>>::type;
+
+      template<typename FIRST, typename NEXT>
+      auto bind(FIRST& first, std::optional<NEXT>& next) -> bool {
+         if constexpr(std::is_void_v<R>) {
+            first.await_resume();
+            next.emplace(std::in_place, [this] { return std::invoke(std::forward<F>(func_)); });
+         } else if constexpr(std::is_reference_v<R>) {
+            next.emplace(std::in_place, [&, this] {
+               return std::invoke(std::forward<F>(func_), static_cast<R>(first.await_resume()));
+            });
+         } else {
+            // keep it, in case f takes it by reference and is lazy.
+            value_.emplace(first.await_resume());
+            next.emplace(std::in_place, [this] {
+               return std::invoke(std::forward<F>(func_), std::move(*value_));
+            });
+         }
+         return true;
+      }
+
+      template<typename FIRST, typename NEXT>
+      auto resume(FIRST&, std::optional<NEXT>& next) -> decltype(auto) {
+         using result_t = decltype(next->awaiter().await_resume());
+         if constexpr(std::is_reference_v<next_awaitable_t>) {
+            return next->awaiter().await_resume();
+         } else {
+            // the next awaitable dies with the awaiter, don't refer into it.
+            return static_cast<pass_on_t<result_t>>(next->awaiter().await_resume());
+         }
+      }
+
+      F func_;
+      [[no_unique_address]] stored_value_t<R> value_{};
+   };
+
+   template<typename F, typename R>
+   struct and_then_policy {
+      static_assert(result_concept<R>, "and_then expects an awaitable of result<T, E>");
+      using first_value_t = decltype(std::declval<R>().value());
+      using error_type = typename std::remove_cvref_t<R>::error_type;
+      using next_awaitable_t = typename std::conditional_t<std::is_void_v<first_value_t>,
+         std::invoke_result<F>, std::invoke_result<F, first_value_t>>::type;
+      using result_type = std::remove_cvref_t<await_result_t<next_awaitable_t>>;
+      static_assert(result_concept<result_type>, "and_then expects f to give an awaitable of result<U, E>");
+      static_assert(std::is_same_v<typename result_type::error_type, error_type>);
+
+      template<typename FIRST, typename NEXT>
+      auto bind(FIRST& first, std::optional<NEXT>& next) -> bool {
+         if constexpr(std::is_reference_v<R>) {
+            return bind_value(static_cast<R>(first.await_resume()), next);
+         } else {
+            value_.emplace(first.await_resume());
+            return bind_value(std::move(*value_), next);
+         }
+      }
+
+      template<typename FIRST, typename NEXT>
+      auto resume(FIRST&, std::optional<NEXT>& next) -> result_type {
+         if(!next) {
+            return unexpected<error_type>{std::move(*error_)};
+         }
+         return next->awaiter().await_resume();
+      }
+
+      F func_;
+      [[no_unique_address]] stored_value_t<R> value_{};
+      std::optional<error_type> error_{};
+
+   private:
+      template<typename V, typename NEXT>
+      auto bind_value(V&& value, std::optional<NEXT>& next) -> bool {
+         if(!value.has_value()) {
+            error_.emplace(std::forward<V>(value).error());
+            return false;
+         }
+         if constexpr(std::is_void_v<first_value_t>) {
+            next.emplace(std::in_place, [this] { return std::invoke(std::forward<F>(func_)); });
+         } else {
+            next.emplace(std::in_place, [&, this] {
+               return std::invoke(std::forward<F>(func_), std::forward<V>(value).value());
+            });
+         }
+         return true;
+      }
+   };
+
+   // F is a pointer to the scheduler.
+   template<typename F, typename R>
+   struct via_policy {
+      using next_awaitable_t = decltype(std::declval<F>()->schedule());
+
+      template<typename FIRST, typename NEXT>
+      auto bind(FIRST&, std::optional<NEXT>& next) -> bool {
+         next.emplace(std::in_place, [this] { return scheduler_->schedule(); });
+         return true;
+      }
+
+      // first is done, and we're on the scheduler now, take its result.
+      template<typename FIRST, typename NEXT>
+      auto resume(FIRST& first, std::optional<NEXT>& next) -> decltype(auto) {
+         next->awaiter().await_resume();
+         return first.await_resume();
+      }
+
+      F scheduler_;
+   };
+
+   template<template<typename, typename> class POLICY, typename F, awaitable_concept A>
+   inline auto bind(F&& func, A&& awaitable) {
+      using awaitable_t = bind_awaitable<POLICY, std::decay_t<F>, stored_awaitable_t<A>>;
+      return awaitable_t{std::forward<F>(func), std::forward<A>(awaitable)};
+   }
+}
+
+template<template<typename, typename> class POLICY, typename F>
+struct bind_transform {
+   explicit bind_transform(F&& f)
+      : func_(std::forward<F>(f))
+   {}
+
+   F func_;
+};
+
+// awaitable | then(f): f takes the value and returns an awaitable, whose
+// result is the result of the whole.
+template<typename F>
+inline auto then(F&& func) -> bind_transform<detail::then_policy, F> {
+   return bind_transform<detail::then_policy, F>{ std::forward<F>(func) };
+}
+
+// awaitable of result<T, E> | and_then(f): f is only called with the value;
+// an error is passed on as result<U, E> without calling f.
+template<typename F>
+inline auto and_then(F&& func) -> bind_transform<detail::and_then_policy, F> {
+   return bind_transform<detail::and_then_policy, F>{ std::forward<F>(func) };
+}
+
+// awaitable | via(s): the awaiting coroutine is resumed by s.schedule()
+// once the awaitable completes. the scheduler should outlive the awaiting.
+template<scheduler_concept S>
+inline auto via(S& scheduler) -> bind_transform<detail::via_policy, S*> {
+   return bind_transform<detail::via_policy, S*>{ std::addressof(scheduler) };
+}
+
+template<typename T, template<typename, typename> class POLICY, typename F>
+inline auto operator|(T&& value, bind_transform<POLICY, F>&& transform) -> decltype(auto) {
+   return detail::bind<POLICY>(std::forward<F>(transform.func_), std::forward<T>(value));
+}
+
+template<typename T, template<typename, typename> class POLICY, typename F>
+inline auto operator|(T&& value, const bind_transform<POLICY, F>& transform) -> decltype(auto) {
+   return detail::bind<POLICY>(transform.func_, std::forward<T>(value));
+}
+
+template<typename T, template<typename, typename> class POLICY, typename F>
+inline auto operator|(T&& value, bind_transform<POLICY, F>& transform) -> decltype(auto) {
+   return detail::bind<POLICY>(transform.func_, std::forward<T>(value));
+}
+
+E_CORO_NS_END
+
+#endif //E_CORO_THEN_H
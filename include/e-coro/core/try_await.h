@@ -0,0 +1,125 @@
+#ifndef E_CORO_TRY_AWAIT_H
+#define E_CORO_TRY_AWAIT_H
+
+#include <e-coro/core/task.h>
+#include <e-coro/core/result.h>
+#include <e-coro/core/awaitable_trait.h>
+#include <coroutine>
+#include <utility>
+
+E_CORO_NS_BEGIN
+
+namespace detail {
+   // a result which is already at hand.
+   template<typename R>
+   struct try_result_awaiter {
+      explicit try_result_awaiter(R&& result) noexcept
+         : result_{std::forward<R>(result)}
+      {}
+
+      auto await_ready() const noexcept -> bool {
+         return result_.has_value();
+      }
+
+      template<typename P>
+      auto await_suspend(std::coroutine_handle<P> self) noexcept -> std::coroutine_handle<> {
+         return self.promise().fail(std::forward<R>(result_).error());
+      }
+
+      auto await_resume() noexcept -> decltype(auto) {
+         return std::forward<R>(result_).value();
+      }
+
+   private:
+      R&& result_;
+   };
+
+   // awaiting a task<result<T, E>>: if it fails, its final_suspend hands the
+   // error over to my promise and resumes my caller directly, thus neither
+   // an extra frame nor a branch in my body is needed.
+   template<typename TASK_AWAITER>
+   struct try_task_awaiter : TASK_AWAITER {
+      explicit try_task_awaiter(TASK_AWAITER&& awaiter) noexcept
+         : TASK_AWAITER{std::move(awaiter)}
+      {}
+
+      auto await_ready() noexcept -> bool {
+         return TASK_AWAITER::await_ready() && this->self_.promise().result().has_value();
+      }
+
+      template<typename P>
+      auto await_suspend(std::coroutine_handle<P> caller) noexcept -> std::coroutine_handle<> {
+         if(detail::is_task_completed(this->self_)) {
+            // it has failed already.
+            decltype(auto) result = TASK_AWAITER::await_resume();
+            return caller.promise().fail(std::forward<decltype(result)>(result).error());
+         }
+
+         this->self_.promise().propagate_error_to(caller);
+         return TASK_AWAITER::await_suspend(caller);
+      }
+
+      auto await_resume() noexcept -> decltype(auto) {
+         decltype(auto) result = TASK_AWAITER::await_resume();
+         return std::forward<decltype(result)>(result).value();
+      }
+   };
+
+   template<typename T>
+   struct try_task_awaitable {
+      auto operator co_await() && noexcept {
+         return try_task_awaiter{std::move(task_).operator co_await()};
+      }
+
+      task<T> task_;
+   };
+
+   template<typename T>
+   struct is_result_task : std::false_type {};
+
+   template<typename T, typename E>
+   struct is_result_task<task<result<T, E>>> : std::true_type {};
+
+   template<typename A>
+   auto make_result_task(A awaitable) -> task<std::remove_cvref_t<await_result_t<A>>> {
+      co_return co_await static_cast<A&&>(awaitable);
+   }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Inside a coroutine returning task<result<T, E>>,
+//
+//    auto value = co_await try_await(fetch());
+//
+// gives the value if fetch() succeeds; otherwise the error is propagated to
+// the caller right away, and the rest of the body is not executed, which is
+// what a thrown exception would do.
+/////////////////////////////////////////////////////////////////////////////
+template<result_concept R>
+inline auto try_await(R&& result) noexcept {
+   return detail::try_result_awaiter<R>{std::forward<R>(result)};
+}
+
+template<typename T, typename E>
+inline auto try_await(const task<result<T, E>>& task) noexcept {
+   return detail::try_task_awaiter{task.operator co_await()};
+}
+
+template<typename T, typename E>
+inline auto try_await(task<result<T, E>>&& task) noexcept {
+   return detail::try_task_awaiter{std::move(task).operator co_await()};
+}
+
+// any other awaitable of result is adapted by a task, which costs a frame.
+template<awaitable_concept A>
+requires (!detail::is_result_task<std::remove_cvref_t<A>>::value &&
+          result_concept<await_result_t<A>>)
+inline auto try_await(A&& awaitable) {
+   using task_t = decltype(detail::make_result_task(std::forward<A>(awaitable)));
+   return detail::try_task_awaitable<typename task_t::promise_type::value_type>{
+      detail::make_result_task(std::forward<A>(awaitable))};
+}
+
+E_CORO_NS_END
+
+#endif //E_CORO_TRY_AWAIT_H
@@ -0,0 +1,180 @@
+#ifndef E_CORO_VALUE_TASK_H
+#define E_CORO_VALUE_TASK_H
+
+#include <e-coro/core/task.h>
+#include <e-coro/core/awaitable_trait.h>
+#include <coroutine>
+#include <concepts>
+#include <optional>
+#include <utility>
+
+E_CORO_NS_BEGIN
+
+namespace detail {
+   template<typename T>
+   struct ready_value {
+      ready_value() noexcept = default;
+
+      template<typename ... ARGS>
+      explicit ready_value(std::in_place_t, ARGS&& ... args)
+         : value_{std::in_place, std::forward<ARGS>(args)...}
+      {}
+
+      auto has_value() const noexcept -> bool {
+         return value_.has_value();
+      }
+
+      auto get() & noexcept -> T& {
+         return *value_;
+      }
+
+      auto get() && noexcept -> T&& {
+         return std::move(*value_);
+      }
+
+   private:
+      std::optional<T> value_;
+   };
+
+   template<typename T>
+   struct ready_value<T&> {
+      ready_value() noexcept = default;
+
+      explicit ready_value(std::in_place_t, T& value) noexcept
+         : value_{std::addressof(value)}
+      {}
+
+      auto has_value() const noexcept -> bool {
+         return value_ != nullptr;
+      }
+
+      auto get() const noexcept -> T& {
+         return *value_;
+      }
+
+   private:
+      T* value_{};
+   };
+
+   template<>
+   struct ready_value<void> {
+      ready_value() noexcept = default;
+      explicit ready_value(std::in_place_t) noexcept : ready_{true} {}
+
+      auto has_value() const noexcept -> bool {
+         return ready_;
+      }
+
+      auto get() const noexcept {}
+
+   private:
+      bool ready_{false};
+   };
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// A value_task either carries a result which is already available, or a
+// task<T> which computes it. A function which mostly hits a cache could
+// return the value directly without allocating a coroutine frame, and only
+// fall back to a real coroutine on a miss:
+//
+//    auto lookup(int key) -> value_task<int> {
+//       if(auto* p = cache.find(key)) return *p;
+//       return fetch(key); // task<int>
+//    }
+//
+// For callers it is awaited exactly like a task<T>.
+/////////////////////////////////////////////////////////////////////////////
+template <typename T = void>
+struct [[nodiscard("it will be destroyed automatically otherwise")]] value_task {
+   value_task() noexcept = default;
+
+   value_task(task<T>&& task) noexcept
+      : task_{std::move(task)}
+   {}
+
+   template<typename ... ARGS>
+   explicit value_task(std::in_place_t, ARGS&& ... args)
+      : value_{std::in_place, std::forward<ARGS>(args)...}
+   {}
+
+   template<typename R>
+   requires (!std::is_void_v<T> &&
+             !std::same_as<std::decay_t<R>, value_task> &&
+             !std::same_as<std::decay_t<R>, task<T>> &&
+             std::convertible_to<R, T>)
+   value_task(R&& value)
+      : value_{std::in_place, std::forward<R>(value)}
+   {}
+
+   value_task(value_task&&) noexcept = default;
+   value_task& operator=(value_task&&) noexcept = default;
+
+   value_task(value_task const&) noexcept = delete;
+   value_task& operator=(value_task const&) noexcept = delete;
+
+private:
+   template<typename TASK_AWAITER>
+   struct awaitable_base {
+      awaitable_base(detail::ready_value<T>* value, TASK_AWAITER&& task_awaiter) noexcept
+         : value_{value}
+         , task_awaiter_{std::move(task_awaiter)}
+      {}
+
+      auto await_ready() noexcept -> bool {
+         // a ready value never suspends the caller, nor touches any frame.
+         return value_ != nullptr || task_awaiter_.await_ready();
+      }
+
+      auto await_suspend(std::coroutine_handle<> caller) noexcept {
+         return task_awaiter_.await_suspend(caller);
+      }
+
+   protected:
+      detail::ready_value<T>* value_;
+      TASK_AWAITER task_awaiter_;
+   };
+
+   auto value_ptr() noexcept -> detail::ready_value<T>* {
+      return value_.has_value() ? std::addressof(value_) : nullptr;
+   }
+
+public:
+   // caller awaits me, and i'm a lvalue-reference
+   auto operator co_await() & noexcept {
+      using task_awaiter = decltype(std::declval<task<T> const&>().operator co_await());
+      struct awaitable : awaitable_base<task_awaiter> {
+         using awaitable_base<task_awaiter>::awaitable_base;
+         auto await_resume() noexcept -> decltype(auto) {
+            if(this->value_ != nullptr) return this->value_->get();
+            return this->task_awaiter_.await_resume();
+         }
+      };
+      return awaitable{ value_ptr(), task_.operator co_await() };
+   }
+
+   // caller awaits me, and i'm a rvalue-reference
+   auto operator co_await() && noexcept {
+      using task_awaiter = decltype(std::declval<task<T> const&&>().operator co_await());
+      struct awaitable : awaitable_base<task_awaiter> {
+         using awaitable_base<task_awaiter>::awaitable_base;
+         auto await_resume() noexcept -> decltype(auto) {
+            if(this->value_ != nullptr) return std::move(*this->value_).get();
+            return this->task_awaiter_.await_resume();
+         }
+      };
+      return awaitable{ value_ptr(), std::move(task_).operator co_await() };
+   }
+
+   auto is_ready() const noexcept -> bool {
+      return value_.has_value() || task_.is_ready();
+   }
+
+private:
+   detail::ready_value<T> value_;
+   task<T> task_;
+};
+
+E_CORO_NS_END
+
+#endif //E_CORO_VALUE_TASK_H
@@ -7,21 +7,23 @@
 
 #include <e-coro/e_coro_ns.h>
 #include <e-coro/core/detail/when_all_ready_awaitable.h>
-#include <e-coro/core/detail/when_all_task.h>
+#include <e-coro/core/detail/when_all_awaiter_task.h>
 #include <e-coro/core/awaitable_trait.h>
 
 E_CORO_NS_BEGIN
 
+// each child is awaited in place, nothing is allocated for it. an lvalue
+// argument is kept by reference rather than copied, so it has to outlive
+// the awaitable returned.
 template<typename... Xs>
 [[nodiscard("this is an awaitable")]]
 inline auto when_all_ready(Xs&&... xs) {
    using result_t =
       detail::when_all_ready_awaitable<
          std::tuple<
-            detail::when_all_task<
-               await_result_t<std::decay_t<Xs>>>...>>;
+            detail::when_all_awaiter_task<Xs>...>>;
    return result_t{
-      std::make_tuple(detail::make_when_all_task(std::forward<Xs>(xs))...)};
+      detail::when_all_awaiter_task<Xs>{std::forward<Xs>(xs)}...};
 }
 
 E_CORO_NS_END
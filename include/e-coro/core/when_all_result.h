@@ -0,0 +1,37 @@
+#ifndef E_CORO_WHEN_ALL_RESULT_H
+#define E_CORO_WHEN_ALL_RESULT_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/core/detail/when_all_result_awaitable.h>
+#include <e-coro/core/detail/when_all_task.h>
+#include <e-coro/core/awaitable_trait.h>
+#include <e-coro/core/result.h>
+
+E_CORO_NS_BEGIN
+
+/////////////////////////////////////////////////////////////////////////////
+// Awaits awaitables of result<T, E>, which are started one after another.
+// Gives result<std::tuple<T...>, E> with the first error by argument order.
+// Once a child has failed, the ones not started yet are never started; those
+// already running are still waited for, since there's no cancellation.
+/////////////////////////////////////////////////////////////////////////////
+template<typename... Xs>
+[[nodiscard("this is an awaitable")]]
+inline auto when_all_result(Xs&&... xs) {
+   static_assert((result_concept<await_result_t<std::decay_t<Xs>>> && ...),
+      "when_all_result only accepts awaitables of result<T, E>");
+
+   using result_t =
+      detail::when_all_result_awaitable<
+         std::tuple<
+            detail::when_all_task<
+               await_result_t<std::decay_t<Xs>>,
+               detail::when_all_result_counter>...>>;
+   return result_t{
+      std::make_tuple(
+         detail::make_when_all_task<detail::when_all_result_counter>(std::forward<Xs>(xs))...)};
+}
+
+E_CORO_NS_END
+
+#endif //E_CORO_WHEN_ALL_RESULT_H
@@ -0,0 +1,176 @@
+#ifndef E_CORO_ASYNC_STACK_H
+#define E_CORO_ASYNC_STACK_H
+
+#include <e-coro/e_coro_ns.h>
+#include <concepts>
+#include <coroutine>
+#include <cstdint>
+#include <type_traits>
+
+/////////////////////////////////////////////////////////////////////////////
+// Build with E_CORO_ASYNC_STACK=1 to have each task know the task awaiting
+// it and the one it's awaiting, and where it's suspended: the source
+// location and the return address of its latest co_await. Thus the logical
+// chain of a suspended task could be dumped, which a native backtrace can't
+// show. Otherwise the hooks are empty and nothing is left of them.
+//
+// Like E_CORO_TRACING, every translation unit must agree on it.
+/////////////////////////////////////////////////////////////////////////////
+#ifndef E_CORO_ASYNC_STACK
+#define E_CORO_ASYNC_STACK 0
+#endif
+
+#if E_CORO_ASYNC_STACK
+#include <limits>
+#include <source_location>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+#endif
+
+E_CORO_NS_BEGIN
+
+// only pointers to static strings, it's safe to read in a signal handler.
+struct async_frame {
+   async_frame* parent_{};
+   async_frame* child_{};
+   const char* file_{};
+   const char* function_{};
+   std::uint_least32_t line_{};
+   void* return_address_{};
+};
+
+#if E_CORO_ASYNC_STACK
+
+namespace detail {
+   struct async_stack_hooks {
+      async_stack_hooks() noexcept = default;
+      async_stack_hooks(async_stack_hooks const&) = delete;
+      async_stack_hooks& operator=(async_stack_hooks const&) = delete;
+
+      ~async_stack_hooks() noexcept {
+         // short-circuited, or destroyed while suspended.
+         unlink();
+         if(frame_.child_ != nullptr) frame_.child_->parent_ = nullptr;
+      }
+
+      // only a task awaiting a task is linked, the chain ends at anything else.
+      template<typename P>
+      auto link_caller(std::coroutine_handle<P> caller) noexcept -> void {
+         if constexpr(std::is_base_of_v<async_stack_hooks, P>) {
+            frame_.parent_ = &caller.promise().frame_;
+            frame_.parent_->child_ = &frame_;
+         } else {
+            frame_.parent_ = nullptr;
+         }
+      }
+
+      auto unlink() noexcept -> void {
+         if(frame_.parent_ != nullptr && frame_.parent_->child_ == &frame_) {
+            frame_.parent_->child_ = nullptr;
+         }
+         frame_.parent_ = nullptr;
+      }
+
+      // not inlined, so that the return address is in the coroutine body.
+      [[gnu::noinline]]
+      auto record_location(std::source_location const& where) noexcept -> void {
+         frame_.file_ = where.file_name();
+         frame_.function_ = where.function_name();
+         frame_.line_ = where.line();
+         frame_.return_address_ = __builtin_return_address(0);
+      }
+
+      async_frame frame_;
+   };
+
+   inline auto write_all(int fd, const char* s, std::size_t size) noexcept -> void {
+#if defined(__unix__) || defined(__APPLE__)
+      while(size > 0) {
+         auto n = ::write(fd, s, size);
+         if(n <= 0) return;
+         s += n;
+         size -= static_cast<std::size_t>(n);
+      }
+#else
+      (void)fd; (void)s; (void)size;
+#endif
+   }
+
+   inline auto write_str(int fd, const char* s) noexcept -> void {
+      if(s == nullptr) s = "?";
+      std::size_t size = 0;
+      while(s[size] != '\0') ++size;
+      write_all(fd, s, size);
+   }
+
+   // base 2 to 16; the buffer takes as many digits as base 2 gives.
+   inline auto write_number(int fd, std::uintptr_t value, unsigned base) noexcept -> void {
+      char buf[std::numeric_limits<std::uintptr_t>::digits];
+      auto p = buf + sizeof(buf);
+      do {
+         auto digit = static_cast<char>(value % base);
+         *--p = static_cast<char>(digit < 10 ? '0' + digit : 'a' + digit - 10);
+         value /= base;
+      } while(value != 0);
+      write_all(fd, p, static_cast<std::size_t>(buf + sizeof(buf) - p));
+   }
+}
+
+// call f with each frame of the chain frame is in, the innermost first.
+template<typename F>
+inline auto for_each_async_frame(const async_frame* frame, F&& f) -> void {
+   if(frame == nullptr) return;
+   while(frame->child_ != nullptr) frame = frame->child_;
+   for(; frame != nullptr; frame = frame->parent_) {
+      f(*frame);
+   }
+}
+
+template<std::derived_from<detail::async_stack_hooks> P>
+inline auto async_frame_of(std::coroutine_handle<P> handle) noexcept -> const async_frame* {
+   return handle ? &handle.promise().frame_ : nullptr;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Write the chain like a backtrace, one line per task, innermost first:
+//    #0 0x55d0c0a1b2c3 in handle_request() at server.cpp:42
+// Only write(2) is used, thus it could be called from a signal handler;
+// the chain shouldn't be changing meanwhile though.
+/////////////////////////////////////////////////////////////////////////////
+inline auto dump_async_stack(int fd, const async_frame* frame) noexcept -> void {
+   unsigned index = 0;
+   for_each_async_frame(frame, [&](const async_frame& f) {
+      detail::write_str(fd, "#");
+      detail::write_number(fd, index++, 10);
+      detail::write_str(fd, " 0x");
+      detail::write_number(fd, reinterpret_cast<std::uintptr_t>(f.return_address_), 16);
+      detail::write_str(fd, " in ");
+      detail::write_str(fd, f.function_);
+      detail::write_str(fd, " at ");
+      detail::write_str(fd, f.file_);
+      detail::write_str(fd, ":");
+      detail::write_number(fd, f.line_, 10);
+      detail::write_str(fd, "\n");
+   });
+}
+
+#else
+
+namespace detail {
+   struct async_stack_hooks {
+      template<typename P>
+      auto link_caller(std::coroutine_handle<P>) const noexcept -> void {}
+      auto unlink() const noexcept -> void {}
+      template<typename LOCATION>
+      auto record_location(LOCATION const&) const noexcept -> void {}
+   };
+
+   static_assert(std::is_empty_v<async_stack_hooks>);
+}
+
+#endif
+
+E_CORO_NS_END
+
+#endif //E_CORO_ASYNC_STACK_H
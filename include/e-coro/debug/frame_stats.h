@@ -0,0 +1,177 @@
+#ifndef E_CORO_FRAME_STATS_H
+#define E_CORO_FRAME_STATS_H
+
+#include <e-coro/e_coro_ns.h>
+#include <type_traits>
+
+/////////////////////////////////////////////////////////////////////////////
+// Build with E_CORO_FRAME_STATS=1 to have each coroutine frame allocated by
+// the promises of e-coro accounted to its coroutine: the frame size, how
+// many are alive, the most ever alive at once, and the bytes allocated in
+// total. Otherwise the hooks are empty, and frames are allocated by the
+// global operator new as usual.
+//
+// Like E_CORO_TRACING, every translation unit must agree on it.
+/////////////////////////////////////////////////////////////////////////////
+#ifndef E_CORO_FRAME_STATS
+#define E_CORO_FRAME_STATS 0
+#endif
+
+#if E_CORO_FRAME_STATS
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <ostream>
+#include <source_location>
+#include <string_view>
+#include <vector>
+
+#ifndef E_CORO_FRAME_STATS_SLOTS
+#define E_CORO_FRAME_STATS_SLOTS 256
+#endif
+#endif
+
+E_CORO_NS_BEGIN
+
+#if E_CORO_FRAME_STATS
+
+struct frame_stats {
+   std::string_view name_;
+   std::size_t frame_size_{};
+   std::uint64_t allocations_{};
+   std::uint64_t live_{};
+   std::uint64_t peak_live_{};
+   std::uint64_t total_bytes_{};
+};
+
+namespace detail {
+   /////////////////////////////////////////////////////////////////////////
+   // A frame may be freed by another thread than the one allocated it, so
+   // unlike the task stats, it's one table shared by all threads, updated
+   // by atomic RMWs; which is cheap next to the allocation itself.
+   /////////////////////////////////////////////////////////////////////////
+   struct frame_stats_table {
+      constexpr static std::size_t slots = E_CORO_FRAME_STATS_SLOTS;
+      static_assert((slots & (slots - 1)) == 0, "slots should be a power of 2");
+
+      struct entry {
+         auto on_allocate(std::size_t size) noexcept -> void {
+            frame_size_.store(size, std::memory_order_relaxed);
+            allocations_.fetch_add(1, std::memory_order_relaxed);
+            total_bytes_.fetch_add(size, std::memory_order_relaxed);
+            auto live = live_.fetch_add(1, std::memory_order_relaxed) + 1;
+            auto peak = peak_live_.load(std::memory_order_relaxed);
+            while(live > peak && !peak_live_.compare_exchange_weak(peak, live, std::memory_order_relaxed));
+         }
+
+         auto on_free() noexcept -> void {
+            live_.fetch_sub(1, std::memory_order_relaxed);
+         }
+
+         std::atomic<const char*> name_{nullptr};
+         std::atomic<std::size_t> frame_size_{0};
+         std::atomic<std::uint64_t> allocations_{0};
+         std::atomic<std::uint64_t> live_{0};
+         std::atomic<std::uint64_t> peak_live_{0};
+         std::atomic<std::uint64_t> total_bytes_{0};
+      };
+
+      static auto instance() -> frame_stats_table& {
+         static frame_stats_table t;
+         return t;
+      }
+
+      // nullptr if the table is full.
+      auto find(const char* name) noexcept -> entry* {
+         auto hash = std::hash<const void*>{}(name);
+         for(std::size_t i = 0; i < slots; ++i) {
+            auto& e = entries_[(hash + i) & (slots - 1)];
+            auto n = e.name_.load(std::memory_order_acquire);
+            if(n == nullptr && e.name_.compare_exchange_strong(n, name, std::memory_order_acq_rel)) {
+               return &e;
+            }
+            if(n == name) return &e;
+         }
+         return nullptr;
+      }
+
+      std::array<entry, slots> entries_;
+   };
+
+   /////////////////////////////////////////////////////////////////////////
+   // A base of the promises: their frames are allocated with a header in
+   // front, which tells the entry to account the deallocation to. The
+   // coroutine is known from the default argument, since operator new is
+   // called in its body, before the promise is there.
+   /////////////////////////////////////////////////////////////////////////
+   struct frame_stats_hooks {
+      constexpr static std::size_t header_size = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+      static_assert(sizeof(frame_stats_table::entry*) <= header_size);
+
+      static auto operator new(std::size_t size, std::source_location where = std::source_location::current()) -> void* {
+         auto entry = frame_stats_table::instance().find(where.function_name());
+         if(entry != nullptr) entry->on_allocate(size);
+         auto p = static_cast<char*>(::operator new(size + header_size));
+         *reinterpret_cast<frame_stats_table::entry**>(p) = entry;
+         return p + header_size;
+      }
+
+      static auto operator delete(void* frame, std::size_t size) noexcept -> void {
+         auto p = static_cast<char*>(frame) - header_size;
+         if(auto entry = *reinterpret_cast<frame_stats_table::entry**>(p)) {
+            entry->on_free();
+         }
+         ::operator delete(p, size + header_size);
+      }
+   };
+}
+
+// all recorded so far, of each coroutine, the most bytes in total first.
+inline auto frame_stats_snapshot() -> std::vector<frame_stats> {
+   std::vector<frame_stats> result;
+   for(auto& e : detail::frame_stats_table::instance().entries_) {
+      auto name = e.name_.load(std::memory_order_acquire);
+      if(name == nullptr) continue;
+      auto& s = result.emplace_back();
+      s.name_ = name;
+      s.frame_size_ = e.frame_size_.load(std::memory_order_relaxed);
+      s.allocations_ = e.allocations_.load(std::memory_order_relaxed);
+      s.live_ = e.live_.load(std::memory_order_relaxed);
+      s.peak_live_ = e.peak_live_.load(std::memory_order_relaxed);
+      s.total_bytes_ = e.total_bytes_.load(std::memory_order_relaxed);
+   }
+   std::sort(result.begin(), result.end(), [](auto& lhs, auto& rhs) {
+      return lhs.total_bytes_ > rhs.total_bytes_;
+   });
+   return result;
+}
+
+// one line per coroutine, in the order of the snapshot.
+inline auto write_frame_stats(std::ostream& out) -> void {
+   for(auto& s : frame_stats_snapshot()) {
+      out << s.frame_size_ << " bytes, "
+          << s.allocations_ << " allocated, "
+          << s.live_ << " live, "
+          << s.peak_live_ << " at peak, "
+          << s.total_bytes_ << " bytes in total: "
+          << s.name_ << '\n';
+   }
+}
+
+#else
+
+namespace detail {
+   struct frame_stats_hooks {};
+
+   static_assert(std::is_empty_v<frame_stats_hooks>);
+}
+
+#endif
+
+E_CORO_NS_END
+
+#endif //E_CORO_FRAME_STATS_H
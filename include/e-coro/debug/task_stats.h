@@ -0,0 +1,434 @@
+#ifndef E_CORO_TASK_STATS_H
+#define E_CORO_TASK_STATS_H
+
+#include <e-coro/e_coro_ns.h>
+#include <coroutine>
+#include <type_traits>
+
+/////////////////////////////////////////////////////////////////////////////
+// Build with E_CORO_TASK_STATS=1 to have each task tagged by the coroutine
+// it runs, and to have its running time, suspended time and resumptions
+// accumulated per coroutine, into histograms of each thread. Otherwise the
+// hooks are empty and nothing is left of them.
+//
+// Like E_CORO_TRACING, every translation unit must agree on it.
+/////////////////////////////////////////////////////////////////////////////
+#ifndef E_CORO_TASK_STATS
+#define E_CORO_TASK_STATS 0
+#endif
+
+#if E_CORO_TASK_STATS
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <string_view>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// the coroutines recorded per thread; more are counted by task_stats_dropped().
+#ifndef E_CORO_TASK_STATS_SLOTS
+#define E_CORO_TASK_STATS_SLOTS 64
+#endif
+#endif
+
+E_CORO_NS_BEGIN
+
+#if E_CORO_TASK_STATS
+
+// where a coroutine is, given by default to the constructor of its promise.
+struct task_site {
+   explicit task_site(std::source_location where = std::source_location::current()) noexcept
+      : name_{where.function_name()}
+   {}
+
+   const char* name_;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Log-linear buckets, 4 per power of 2, thus a value is off by 25% at most;
+// exact below 4ns, and anything from 2^40ns (~18 minutes) on is put in the
+// last one.
+/////////////////////////////////////////////////////////////////////////////
+struct latency_histogram {
+   constexpr static std::size_t sub_buckets = 4;
+   constexpr static std::size_t max_exponent = 40;
+   // 4 below 4ns, 4 for each power of 2 up to 2^40ns, and the last one.
+   constexpr static std::size_t buckets = sub_buckets * (max_exponent - 1) + 1;
+
+   constexpr static auto bucket_of(std::uint64_t ns) noexcept -> std::size_t {
+      if(ns < sub_buckets) return static_cast<std::size_t>(ns);
+      auto exponent = static_cast<std::size_t>(std::bit_width(ns)) - 1;
+      if(exponent >= max_exponent) return buckets - 1;
+      auto sub = static_cast<std::size_t>(ns >> (exponent - 2)) & (sub_buckets - 1);
+      return sub_buckets * (exponent - 1) + sub;
+   }
+
+   // the least value of a bucket.
+   constexpr static auto lower_bound(std::size_t bucket) noexcept -> std::uint64_t {
+      if(bucket < sub_buckets) return bucket;
+      auto exponent = bucket / sub_buckets + 1;
+      return static_cast<std::uint64_t>(sub_buckets + bucket % sub_buckets) << (exponent - 2);
+   }
+
+   auto count() const noexcept -> std::uint64_t {
+      std::uint64_t n = 0;
+      for(auto c : counts_) n += c;
+      return n;
+   }
+
+   // the least value no less than the given ratio of all, 0 if there's none.
+   auto percentile(double ratio) const noexcept -> std::uint64_t {
+      auto total = count();
+      if(total == 0) return 0;
+      auto wanted = static_cast<std::uint64_t>(ratio * static_cast<double>(total));
+      std::uint64_t n = 0;
+      for(std::size_t i = 0; i < buckets; ++i) {
+         n += counts_[i];
+         if(n > wanted || n == total) return lower_bound(i);
+      }
+      return lower_bound(buckets - 1);
+   }
+
+   std::array<std::uint64_t, buckets> counts_{};
+};
+
+struct task_stats {
+   std::string_view name_;
+   std::uint64_t resumes_{};
+   std::uint64_t running_ns_{};
+   std::uint64_t suspended_ns_{};
+   latency_histogram running_;
+   latency_histogram suspended_;
+};
+
+namespace detail {
+   /////////////////////////////////////////////////////////////////////////
+   // The cheapest clock at hand: the TSC on x86, which is invariant and
+   // synchronized over the cores on anything recent; steady_clock elsewhere.
+   // A reading costs several times more than the rest of the bookkeeping,
+   // thus it's one per transition, taken over across a symmetric transfer.
+   // Ticks are recorded as they are, and converted to ns only by a
+   // snapshot.
+   //
+   // On a VM where a reading of the TSC takes ~19ns, a resume costs ~20ns,
+   // a suspend and resume ~40ns, and a co_await of a task done right away
+   // ~55ns; test_task_stats_cost.cpp keeps a resume under 35ns.
+   /////////////////////////////////////////////////////////////////////////
+   struct task_stats_clock {
+      static auto now() noexcept -> std::uint64_t {
+#if defined(__x86_64__) || defined(__i386__)
+         return __rdtsc();
+#else
+         return steady_ns();
+#endif
+      }
+
+      static auto steady_ns() noexcept -> std::uint64_t {
+         auto t = std::chrono::steady_clock::now().time_since_epoch();
+         return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t).count());
+      }
+
+      // measured over 1ms at least, since the clock is made.
+      auto ns_per_tick() const noexcept -> double {
+#if defined(__x86_64__) || defined(__i386__)
+         std::uint64_t ns, ticks;
+         do {
+            ns = steady_ns();
+            ticks = now();
+         } while(ns - ns0_ < 1'000'000 || ticks == ticks0_);
+         return static_cast<double>(ns - ns0_) / static_cast<double>(ticks - ticks0_);
+#else
+         return 1.0;
+#endif
+      }
+
+   private:
+      const std::uint64_t ns0_ = steady_ns();
+      const std::uint64_t ticks0_ = now();
+   };
+
+   /////////////////////////////////////////////////////////////////////////
+   // Each thread has a table of its own, which is only written by it; a
+   // counter is updated with a plain load and store, no read-modify-write.
+   // A scraper reads them as they are, thus may miss the latest updates.
+   /////////////////////////////////////////////////////////////////////////
+   struct task_stats_table {
+      constexpr static std::size_t slots = E_CORO_TASK_STATS_SLOTS;
+      static_assert((slots & (slots - 1)) == 0, "slots should be a power of 2");
+
+      struct counter {
+         auto add(std::uint64_t n) noexcept -> void {
+            value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+         }
+         auto get() const noexcept -> std::uint64_t {
+            return value_.load(std::memory_order_relaxed);
+         }
+         std::atomic<std::uint64_t> value_{0};
+      };
+
+      struct entry {
+         auto record(std::array<counter, latency_histogram::buckets>& histogram, counter& total, std::uint64_t ticks) noexcept {
+            histogram[latency_histogram::bucket_of(ticks)].add(1);
+            total.add(ticks);
+         }
+
+         std::atomic<const char*> name_{nullptr};
+         counter resumes_;
+         counter running_ticks_;
+         counter suspended_ticks_;
+         std::array<counter, latency_histogram::buckets> running_;
+         std::array<counter, latency_histogram::buckets> suspended_;
+      };
+
+      // nullptr if the table is full, which is counted in dropped_.
+      auto find(const char* name) noexcept -> entry* {
+         auto hash = std::hash<const void*>{}(name);
+         for(std::size_t i = 0; i < slots; ++i) {
+            auto& e = entries_[(hash + i) & (slots - 1)];
+            auto n = e.name_.load(std::memory_order_relaxed);
+            if(n == name) return &e;
+            if(n == nullptr) {
+               e.name_.store(name, std::memory_order_release);
+               return &e;
+            }
+         }
+         dropped_.add(1);
+         return nullptr;
+      }
+
+      std::array<entry, slots> entries_;
+      // the tasks which ran on this thread unrecorded.
+      counter dropped_;
+   };
+
+   struct task_stats_registry {
+      static auto instance() -> task_stats_registry& {
+         static task_stats_registry r;
+         return r;
+      }
+
+      auto add() -> task_stats_table* {
+         std::lock_guard lock{mutex_};
+         return tables_.emplace_back(std::make_unique<task_stats_table>()).get();
+      }
+
+      template<typename F>
+      auto for_each(F&& f) -> void {
+         std::lock_guard lock{mutex_};
+         for(auto& t : tables_) f(*t);
+      }
+
+      auto clock() const noexcept -> task_stats_clock const& {
+         return clock_;
+      }
+
+   private:
+      task_stats_clock clock_;
+      std::mutex mutex_;
+      std::vector<std::unique_ptr<task_stats_table>> tables_;
+   };
+
+   inline auto task_stats_local() noexcept -> task_stats_table* {
+      static thread_local task_stats_table* mine = task_stats_registry::instance().add();
+      return mine;
+   }
+
+   /////////////////////////////////////////////////////////////////////////
+   // A reading taken right before a symmetric transfer is the same moment
+   // the one transferred to starts or resumes at, thus it's taken over by
+   // it rather than read again: a task awaiting a task done right away
+   // takes 2 readings, not 4. to_ is set only right before the transfer,
+   // and cleared by the next one to look at it.
+   /////////////////////////////////////////////////////////////////////////
+   struct task_stats_handoff {
+      const void* to_;
+      std::uint64_t at_;
+   };
+
+   inline thread_local task_stats_handoff task_stats_handoff_{};
+
+   struct task_stats_hooks {
+      explicit task_stats_hooks(task_site site) noexcept
+         : name_{site.name_}
+      {}
+
+      auto on_start() noexcept -> void {
+         mark_ = taken_over();
+      }
+
+      // the running time is recorded once it's resumed, as it's not known
+      // till then whether it's suspended after all.
+      auto on_suspend() noexcept -> void {
+         suspended_at_ = handed_over();
+      }
+
+      // it's running on since mark_.
+      auto on_suspend_cancelled() noexcept -> void {}
+
+      auto on_resume() noexcept -> void {
+         auto t = taken_over();
+         if(auto e = entry()) {
+            e->resumes_.add(1);
+            e->record(e->running_, e->running_ticks_, suspended_at_ - mark_);
+            e->record(e->suspended_, e->suspended_ticks_, t - suspended_at_);
+         }
+         mark_ = t;
+      }
+
+      auto on_complete() noexcept -> void {
+         running(handed_over());
+      }
+
+      // i'm started right away by caller, suspended just before; if it's a
+      // task, its reading is my start, and mine as i'm done is its resume.
+      template<typename P>
+      auto started_by(std::coroutine_handle<P> caller) noexcept -> void {
+         if constexpr(std::is_base_of_v<task_stats_hooks, P>) {
+            caller_ = static_cast<task_stats_hooks*>(&caller.promise());
+            task_stats_handoff_.to_ = this;
+         } else {
+            caller_ = nullptr;
+         }
+      }
+
+      // i'm done, and my caller is resumed right away.
+      auto hand_off_to_caller() noexcept -> void {
+         if(caller_ != nullptr) task_stats_handoff_.to_ = caller_;
+      }
+
+   private:
+      static auto now() noexcept -> std::uint64_t {
+         return task_stats_clock::now();
+      }
+
+      auto handed_over() noexcept -> std::uint64_t {
+         auto t = now();
+         task_stats_handoff_ = {nullptr, t};
+         return t;
+      }
+
+      auto taken_over() noexcept -> std::uint64_t {
+         auto& handoff = task_stats_handoff_;
+         if(handoff.to_ == this) {
+            handoff.to_ = nullptr;
+            return handoff.at_;
+         }
+         handoff.to_ = nullptr;
+         return now();
+      }
+
+      // looked up again only if i'm moved to another thread.
+      auto entry() noexcept -> task_stats_table::entry* {
+         auto table = task_stats_local();
+         if(table != table_) {
+            table_ = table;
+            entry_ = table->find(name_);
+         }
+         return entry_;
+      }
+
+      auto running(std::uint64_t t) noexcept -> void {
+         if(auto e = entry()) {
+            e->record(e->running_, e->running_ticks_, t - mark_);
+         }
+         mark_ = t;
+      }
+
+   private:
+      const char* name_;
+      task_stats_hooks* caller_{};
+      task_stats_table* table_{};
+      task_stats_table::entry* entry_{};
+      std::uint64_t mark_{};
+      std::uint64_t suspended_at_{};
+   };
+}
+
+namespace detail {
+   inline auto ticks_to_ns(std::uint64_t ticks, double ns_per_tick) noexcept -> std::uint64_t {
+      return static_cast<std::uint64_t>(static_cast<double>(ticks) * ns_per_tick);
+   }
+
+   // a bucket of ticks is put into the bucket its least value falls in.
+   inline auto merge_ticks(latency_histogram& to,
+                           std::array<task_stats_table::counter, latency_histogram::buckets> const& from,
+                           double ns_per_tick) noexcept -> void {
+      for(std::size_t i = 0; i < latency_histogram::buckets; ++i) {
+         auto ns = ticks_to_ns(latency_histogram::lower_bound(i), ns_per_tick);
+         to.counts_[latency_histogram::bucket_of(ns)] += from[i].get();
+      }
+   }
+}
+
+// all recorded so far, of each coroutine, merged over the threads.
+inline auto task_stats_snapshot() -> std::vector<task_stats> {
+   std::vector<task_stats> result;
+   auto& registry = detail::task_stats_registry::instance();
+   auto ns_per_tick = registry.clock().ns_per_tick();
+   registry.for_each([&](detail::task_stats_table& table) {
+      for(auto& e : table.entries_) {
+         auto name = e.name_.load(std::memory_order_acquire);
+         if(name == nullptr) continue;
+
+         auto found = std::find_if(result.begin(), result.end(), [&](auto& s) { return s.name_ == name; });
+         if(found == result.end()) {
+            found = result.insert(result.end(), task_stats{});
+            found->name_ = name;
+         }
+         auto& s = *found;
+         s.resumes_ += e.resumes_.get();
+         s.running_ns_ += detail::ticks_to_ns(e.running_ticks_.get(), ns_per_tick);
+         s.suspended_ns_ += detail::ticks_to_ns(e.suspended_ticks_.get(), ns_per_tick);
+         detail::merge_ticks(s.running_, e.running_, ns_per_tick);
+         detail::merge_ticks(s.suspended_, e.suspended_, ns_per_tick);
+      }
+   });
+   return result;
+}
+
+// the tasks which went unrecorded, as the table of a thread they ran on
+// was full; if it's not 0, E_CORO_TASK_STATS_SLOTS is to be raised.
+inline auto task_stats_dropped() -> std::uint64_t {
+   std::uint64_t dropped = 0;
+   detail::task_stats_registry::instance().for_each([&](detail::task_stats_table& table) {
+      dropped += table.dropped_.get();
+   });
+   return dropped;
+}
+
+#else
+
+struct task_site {};
+
+namespace detail {
+   struct task_stats_hooks {
+      explicit task_stats_hooks(task_site) noexcept {}
+
+      auto on_start() const noexcept -> void {}
+      auto on_suspend() const noexcept -> void {}
+      auto on_resume() const noexcept -> void {}
+      auto on_suspend_cancelled() const noexcept -> void {}
+      auto on_complete() const noexcept -> void {}
+      template<typename P>
+      auto started_by(std::coroutine_handle<P>) const noexcept -> void {}
+      auto hand_off_to_caller() const noexcept -> void {}
+   };
+
+   static_assert(std::is_empty_v<task_stats_hooks>);
+}
+
+#endif
+
+E_CORO_NS_END
+
+#endif //E_CORO_TASK_STATS_H
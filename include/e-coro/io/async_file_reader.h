@@ -0,0 +1,339 @@
+#ifndef E_CORO_ASYNC_FILE_READER_H
+#define E_CORO_ASYNC_FILE_READER_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/core/result.h>
+#include <e-coro/core/task.h>
+#include <e-coro/debug/frame_stats.h>
+#include <e-coro/scheduler/scheduler_concept.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <system_error>
+#include <utility>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+E_CORO_NS_BEGIN
+
+struct file_reader_options {
+   // bytes per chunk; rounded up to the alignment.
+   std::size_t chunk_size_ = 1 << 20;
+   // reads kept in flight ahead of the consumer.
+   std::size_t read_ahead_ = 4;
+   // bypass the page cache, where the file system supports it.
+   bool direct_ = false;
+};
+
+namespace detail {
+   // a coroutine reading into one buffer over and over, parked in between.
+   struct file_read_loop {
+      struct promise_type : frame_stats_hooks {
+         auto get_return_object() noexcept -> file_read_loop {
+            return file_read_loop{std::coroutine_handle<promise_type>::from_promise(*this)};
+         }
+         auto initial_suspend() noexcept { return std::suspend_always{}; }
+         auto final_suspend() noexcept { return std::suspend_always{}; }
+         auto return_void() noexcept {}
+      };
+
+      std::coroutine_handle<promise_type> handle_;
+   };
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Streams a regular file in chunks, in order, keeping up to read_ahead_
+// reads in flight on a scheduler, so that if the consumer is slower than
+// the disk, every chunk is already there when it's asked for:
+//
+//    auto reader = async_file_reader<static_thread_pool>::open(pool, path);
+//    while(true) {
+//       auto chunk = co_await reader->next();
+//       if(!chunk.has_value()) ...;            // a read failed
+//       if(chunk->empty()) break;              // end of file
+//       parse(*chunk);
+//    }
+//
+// A chunk is valid until next() is called again; then its buffer is handed
+// over to the next read. Buffers are allocated at open, read_ahead_ + 1 of
+// them, page aligned, and so are the coroutines doing the reads, one per
+// buffer; nothing is allocated afterwards.
+//
+// A read is a blocking pread on a thread of the scheduler. Should a reader
+// be destroyed with reads in flight, it doesn't wait for them: they're left
+// to themselves, and the last of them to be done frees the buffers, the
+// coroutines and the file. co_await close() waits for them instead.
+/////////////////////////////////////////////////////////////////////////////
+template<scheduler_concept S>
+struct async_file_reader {
+   constexpr static std::size_t alignment = 4096;
+   using chunk_type = std::span<const std::byte>;
+
+   static auto open(S& scheduler, const char* path, file_reader_options const& options = {})
+      -> result<async_file_reader, std::error_code> {
+      int flags = O_RDONLY | O_CLOEXEC;
+#ifdef O_DIRECT
+      if(options.direct_) flags |= O_DIRECT;
+#endif
+      int fd = ::open(path, flags);
+      if(fd < 0) return unexpected{std::error_code{errno, std::system_category()}};
+      struct ::stat st;
+      if(::fstat(fd, &st) != 0) {
+         auto error = errno;
+         ::close(fd);
+         return unexpected{std::error_code{error, std::system_category()}};
+      }
+      return async_file_reader{scheduler, fd, static_cast<std::uint64_t>(st.st_size), options};
+   }
+
+   async_file_reader(async_file_reader&& other) noexcept
+      : reads_{std::exchange(other.reads_, nullptr)}
+      , size_{other.size_}
+      , chunk_size_{other.chunk_size_}
+      , head_{other.head_}
+      , in_flight_{other.in_flight_}
+      , next_offset_{other.next_offset_}
+      , holding_{other.holding_}
+      , closed_{other.closed_}
+   {}
+
+   async_file_reader(async_file_reader const&) = delete;
+   async_file_reader& operator=(async_file_reader const&) = delete;
+
+   ~async_file_reader() noexcept {
+      if(reads_ != nullptr) reads_->abandon();
+   }
+
+   auto size() const noexcept -> std::uint64_t {
+      return size_;
+   }
+
+private:
+   struct reads;
+
+   struct slot {
+      struct buffer_deleter {
+         auto operator()(std::byte* p) const noexcept -> void {
+            ::operator delete(p, std::align_val_t{alignment});
+         }
+      };
+
+      // pread till it's full, or the end of file.
+      auto read(int fd) noexcept -> void {
+         std::size_t n = 0;
+         while(n < length_) {
+            auto r = ::pread(fd, buffer_.get() + n, length_ - n, static_cast<off_t>(offset_ + n));
+            if(r < 0 && errno == EINTR) continue;
+            if(r < 0) {
+               error_ = errno;
+               break;
+            }
+            if(r == 0) break;
+            n += static_cast<std::size_t>(r);
+         }
+         bytes_ = n;
+      }
+
+      // park the loop, and resume the consumer if it's waiting.
+      auto complete() noexcept {
+         struct awaiter {
+            auto await_ready() const noexcept { return false; }
+            auto await_suspend(std::coroutine_handle<>) noexcept -> std::coroutine_handle<> {
+               auto& state = self_.state_;
+               auto done = static_cast<void*>(&self_);
+               // i might be gone right after, if nobody's waiting.
+               auto waiter = state.exchange(done, std::memory_order_acq_rel);
+               if(waiter == nullptr) return std::noop_coroutine();
+               if(waiter == self_.reads_) {
+                  // the reader's gone; this loop is freed too, if it's the last.
+                  self_.reads_->release();
+                  return std::noop_coroutine();
+               }
+               return std::coroutine_handle<>::from_address(waiter);
+            }
+            auto await_resume() const noexcept {}
+            slot& self_;
+         };
+         return awaiter{*this};
+      }
+
+      auto is_done() const noexcept -> bool {
+         return state_.load(std::memory_order_acquire) == this;
+      }
+
+      std::unique_ptr<std::byte, buffer_deleter> buffer_;
+      std::coroutine_handle<> loop_;
+      reads* reads_{};
+      std::uint64_t offset_{};
+      std::size_t length_{};
+      std::size_t bytes_{};
+      int error_{};
+      /////////////////////////////////////////////////////////////////////
+      // like the one of eager_task:
+      //    nullptr       : reading, nobody's waiting.
+      //    consumer      : reading, the consumer is waiting for it.
+      //    this          : done, or never issued.
+      //    reads_        : reading, the reader's gone.
+      /////////////////////////////////////////////////////////////////////
+      std::atomic<void*> state_{this};
+   };
+
+   /////////////////////////////////////////////////////////////////////////
+   // What the reads need, owned by the reader and by each read it leaves
+   // in flight once it's gone; the last of them frees it.
+   /////////////////////////////////////////////////////////////////////////
+   struct reads {
+      reads(int fd, std::size_t slot_count)
+         : fd_{fd}
+         , slot_count_{slot_count}
+         , slots_{std::make_unique<slot[]>(slot_count)}
+      {}
+
+      ~reads() noexcept {
+         // all parked, or never started.
+         for(std::size_t i = 0; i < slot_count_; ++i) {
+            if(slots_[i].loop_) slots_[i].loop_.destroy();
+         }
+         ::close(fd_);
+      }
+
+      // by the reader, which is gone; nobody's waiting then.
+      auto abandon() noexcept -> void {
+         for(std::size_t i = 0; i < slot_count_; ++i) {
+            refs_.fetch_add(1, std::memory_order_relaxed);
+            void* reading = nullptr;
+            if(!slots_[i].state_.compare_exchange_strong(reading, this, std::memory_order_acq_rel)) {
+               refs_.fetch_sub(1, std::memory_order_relaxed);
+            }
+         }
+         release();
+      }
+
+      auto release() noexcept -> void {
+         if(refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+      }
+
+      const int fd_;
+      const std::size_t slot_count_;
+      std::unique_ptr<slot[]> slots_;
+      std::atomic<std::size_t> refs_{1};
+   };
+
+   static auto read_loop(S& scheduler, int fd, slot& s) -> detail::file_read_loop {
+      while(true) {
+         co_await scheduler.schedule();
+         s.read(fd);
+         co_await s.complete();
+      }
+   }
+
+   async_file_reader(S& scheduler, int fd, std::uint64_t size, file_reader_options const& options)
+      : reads_{new reads{fd, std::max<std::size_t>(options.read_ahead_, 1) + 1}}
+      , size_{size}
+      , chunk_size_{(std::max<std::size_t>(options.chunk_size_, 1) + alignment - 1) / alignment * alignment} {
+      for(std::size_t i = 0; i < slot_count(); ++i) {
+         auto& s = reads_->slots_[i];
+         s.buffer_.reset(static_cast<std::byte*>(::operator new(chunk_size_, std::align_val_t{alignment})));
+         s.length_ = chunk_size_;
+         s.reads_ = reads_;
+         s.loop_ = read_loop(scheduler, fd, s).handle_;
+      }
+      for(std::size_t i = 0; i < slot_count() - 1; ++i) {
+         issue();
+      }
+   }
+
+   auto slot_count() const noexcept -> std::size_t {
+      return reads_->slot_count_;
+   }
+
+   // the next chunk goes to the slot after the last one issued.
+   auto issue() noexcept -> void {
+      if(closed_ || next_offset_ >= size_ || in_flight_ == slot_count()) return;
+      auto& s = reads_->slots_[(head_ + in_flight_) % slot_count()];
+      s.offset_ = next_offset_;
+      s.bytes_ = 0;
+      s.error_ = 0;
+      next_offset_ += chunk_size_;
+      ++in_flight_;
+      s.state_.store(nullptr, std::memory_order_relaxed);
+      s.loop_.resume();
+   }
+
+   struct next_awaiter {
+      explicit next_awaiter(async_file_reader& reader) noexcept
+         : reader_{reader}
+      {}
+
+      auto await_ready() const noexcept -> bool {
+         return reader_.in_flight_ == 0 || current().is_done();
+      }
+
+      auto await_suspend(std::coroutine_handle<> consumer) noexcept -> bool {
+         void* state = nullptr;
+         return current().state_.compare_exchange_strong(
+            state,
+            consumer.address(),
+            std::memory_order_release,
+            std::memory_order_acquire);
+      }
+
+      auto await_resume() noexcept -> result<chunk_type, std::error_code> {
+         if(reader_.in_flight_ == 0) return chunk_type{};
+         auto& s = current();
+         reader_.head_ = (reader_.head_ + 1) % reader_.slot_count();
+         --reader_.in_flight_;
+         reader_.holding_ = true;
+         if(s.error_ != 0) {
+            return unexpected{std::error_code{s.error_, std::system_category()}};
+         }
+         return chunk_type{s.buffer_.get(), s.bytes_};
+      }
+
+   private:
+      auto current() const noexcept -> slot& {
+         return reader_.reads_->slots_[reader_.head_];
+      }
+
+      async_file_reader& reader_;
+   };
+
+public:
+   // the next chunk, an empty one at the end of file.
+   [[nodiscard("this is an awaitable")]]
+   auto next() noexcept -> next_awaiter {
+      // the chunk handed out last time is done with, read ahead into it.
+      if(std::exchange(holding_, false)) issue();
+      return next_awaiter{*this};
+   }
+
+   // no more reads; done once the ones in flight are.
+   auto close() -> task<> {
+      closed_ = true;
+      while(in_flight_ > 0) {
+         (void)co_await next();
+      }
+   }
+
+private:
+   reads* reads_;
+   std::uint64_t size_;
+   std::size_t chunk_size_;
+   // the consumer only.
+   std::size_t head_{0};
+   std::size_t in_flight_{0};
+   std::uint64_t next_offset_{0};
+   bool holding_{false};
+   bool closed_{false};
+};
+
+E_CORO_NS_END
+
+#endif //E_CORO_ASYNC_FILE_READER_H
@@ -0,0 +1,293 @@
+#ifndef E_CORO_EPOLL_REACTOR_H
+#define E_CORO_EPOLL_REACTOR_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/scheduler/mpsc_queue.h>
+#include <e-coro/scheduler/schedule_node.h>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <system_error>
+#include <utility>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+E_CORO_NS_BEGIN
+
+namespace detail {
+   // an I/O a coroutine is suspended on, till it's performed.
+   struct io_operation {
+      // try it again, true once it's done, succeeded or failed.
+      bool (*perform_)(io_operation&) noexcept;
+      std::coroutine_handle<> handle_;
+   };
+
+   // a file descriptor registered with a reactor, and who's waiting on it.
+   struct io_entry {
+      int fd_{-1};
+      io_operation* reader_{};
+      io_operation* writer_{};
+   };
+
+   /////////////////////////////////////////////////////////////////////////
+   // An awaiter of an I/O: it's tried right away, and only if it would
+   // block, is the coroutine suspended, waiting on the entry for it to be
+   // tried again. DERIVED provides:
+   //    try_perform() -> bool    as perform_,
+   //    entry() -> io_entry&     the one to wait on,
+   //    await_resume()           the result.
+   /////////////////////////////////////////////////////////////////////////
+   template<typename DERIVED, bool WRITE>
+   struct io_awaiter : io_operation {
+      io_awaiter() noexcept
+         : io_operation{[](io_operation& self) noexcept {
+              return static_cast<DERIVED&>(self).try_perform();
+           }, {}}
+      {}
+
+      io_awaiter(io_awaiter const&) = delete;
+      io_awaiter& operator=(io_awaiter const&) = delete;
+
+      auto await_ready() noexcept -> bool {
+         return static_cast<DERIVED*>(this)->try_perform();
+      }
+
+      auto await_suspend(std::coroutine_handle<> self) noexcept -> void {
+         handle_ = self;
+         auto& entry = static_cast<DERIVED*>(this)->entry();
+         (WRITE ? entry.writer_ : entry.reader_) = this;
+      }
+   };
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// An epoll event loop driving the I/O awaiters. Each file descriptor is
+// registered once, edge triggered, for both directions; an I/O is tried
+// before it suspends, thus an edge missed while nobody waited is harmless.
+// The awaiting coroutine is resumed by the loop, on its thread.
+//
+// The loop is single threaded: I/O objects of a reactor are created, used
+// and destroyed on the thread running it. Other threads get there with
+//    co_await reactor.schedule();
+// and stop() it; both could be called from any thread.
+/////////////////////////////////////////////////////////////////////////////
+struct epoll_reactor {
+   constexpr static std::size_t max_events = 64;
+
+   epoll_reactor() noexcept
+      : epoll_fd_{::epoll_create1(EPOLL_CLOEXEC)}
+      , wake_fd_{::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)} {
+      if(epoll_fd_ < 0 || wake_fd_ < 0) {
+         error_ = std::error_code{errno, std::system_category()};
+         return;
+      }
+      ::epoll_event event{};
+      event.events = EPOLLIN;
+      event.data.ptr = this;
+      if(::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event) != 0) {
+         error_ = std::error_code{errno, std::system_category()};
+      }
+   }
+
+   epoll_reactor(epoll_reactor const&) = delete;
+   epoll_reactor& operator=(epoll_reactor const&) = delete;
+
+   ~epoll_reactor() noexcept {
+      if(wake_fd_ >= 0) ::close(wake_fd_);
+      if(epoll_fd_ >= 0) ::close(epoll_fd_);
+   }
+
+   // why it couldn't be created, if it couldn't.
+   auto error() const noexcept -> std::error_code {
+      return error_;
+   }
+
+   // till stop() is called.
+   auto run() noexcept -> void {
+      while(!stopping_.load(std::memory_order_acquire)) {
+         poll(-1);
+      }
+   }
+
+   // one round, waiting no longer than timeout_ms (-1 for ever); the
+   // number of events handled.
+   auto poll(int timeout_ms) noexcept -> std::size_t {
+      auto n = ::epoll_wait(epoll_fd_, events_.data(), static_cast<int>(max_events), timeout_ms);
+      if(n <= 0) return 0;
+      count_ = static_cast<std::size_t>(n);
+      for(current_ = 0; current_ < count_; ++current_) {
+         auto& event = events_[current_];
+         if(event.data.ptr == this) {
+            drain_scheduled();
+         } else if(event.data.ptr != nullptr) {
+            dispatch(*static_cast<detail::io_entry*>(event.data.ptr), event.events);
+         }
+      }
+      count_ = 0;
+      return static_cast<std::size_t>(n);
+   }
+
+   auto stop() noexcept -> void {
+      stopping_.store(true, std::memory_order_release);
+      wake_up();
+   }
+
+   // run a ready coroutine on the loop; from any thread.
+   auto push(schedule_node& node) noexcept -> void {
+      scheduled_.push(node);
+      if(!notified_.exchange(true, std::memory_order_acq_rel)) {
+         wake_up();
+      }
+   }
+
+   struct schedule_operation {
+      auto await_ready() const noexcept { return false; }
+      auto await_suspend(std::coroutine_handle<> self) noexcept {
+         node_.handle_ = self;
+         reactor_.push(node_);
+      }
+      auto await_resume() const noexcept {}
+
+      epoll_reactor& reactor_;
+      schedule_node node_{};
+   };
+
+   [[nodiscard("this is an awaitable")]]
+   auto schedule() noexcept -> schedule_operation {
+      return schedule_operation{*this};
+   }
+
+   auto add(detail::io_entry& entry) noexcept -> std::error_code {
+      ::epoll_event event{};
+      event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+      event.data.ptr = &entry;
+      if(::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, entry.fd_, &event) != 0) {
+         return std::error_code{errno, std::system_category()};
+      }
+      return {};
+   }
+
+   auto remove(detail::io_entry& entry) noexcept -> void {
+      ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, entry.fd_, nullptr);
+      // it might be gone before the rest of this round is handled.
+      for(auto i = current_ + 1; i < count_; ++i) {
+         if(events_[i].data.ptr == &entry) events_[i].data.ptr = nullptr;
+      }
+   }
+
+private:
+   auto dispatch(detail::io_entry& entry, std::uint32_t events) noexcept -> void {
+      constexpr std::uint32_t readable = EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR;
+      constexpr std::uint32_t writable = EPOLLOUT | EPOLLHUP | EPOLLERR;
+      detail::io_operation* done[2]{};
+      if((events & readable) != 0 && entry.reader_ != nullptr && entry.reader_->perform_(*entry.reader_)) {
+         done[0] = std::exchange(entry.reader_, nullptr);
+      }
+      if((events & writable) != 0 && entry.writer_ != nullptr && entry.writer_->perform_(*entry.writer_)) {
+         done[1] = std::exchange(entry.writer_, nullptr);
+      }
+      // the entry might be gone once either is resumed.
+      auto writer = done[1] != nullptr ? done[1]->handle_ : std::coroutine_handle<>{};
+      if(done[0] != nullptr) done[0]->handle_.resume();
+      if(writer) writer.resume();
+   }
+
+   auto drain_scheduled() noexcept -> void {
+      std::uint64_t value;
+      (void)::read(wake_fd_, &value, sizeof(value));
+      notified_.store(false, std::memory_order_release);
+      while(auto node = scheduled_.pop()) {
+         node->resume();
+      }
+   }
+
+   auto wake_up() noexcept -> void {
+      std::uint64_t one = 1;
+      (void)::write(wake_fd_, &one, sizeof(one));
+   }
+
+private:
+   int epoll_fd_;
+   int wake_fd_;
+   std::error_code error_;
+   std::array<::epoll_event, max_events> events_{};
+   std::size_t current_{0};
+   std::size_t count_{0};
+   mpsc_queue scheduled_;
+   std::atomic<bool> notified_{false};
+   std::atomic<bool> stopping_{false};
+};
+
+namespace detail {
+   /////////////////////////////////////////////////////////////////////////
+   // A file descriptor owned, and registered with a reactor. The entry is
+   // allocated once for the descriptor, so that the owner could be moved
+   // while the reactor points at it.
+   /////////////////////////////////////////////////////////////////////////
+   struct reactor_fd {
+      reactor_fd() noexcept = default;
+
+      // takes the fd, even if it fails.
+      static auto open(epoll_reactor& reactor, int fd) noexcept -> std::pair<reactor_fd, std::error_code> {
+         reactor_fd self;
+         self.reactor_ = &reactor;
+         self.entry_.reset(new(std::nothrow) io_entry{fd});
+         if(self.entry_ == nullptr) {
+            ::close(fd);
+            return {std::move(self), std::make_error_code(std::errc::not_enough_memory)};
+         }
+         auto error = reactor.add(*self.entry_);
+         if(error) {
+            ::close(std::exchange(self.entry_->fd_, -1));
+         }
+         return {std::move(self), error};
+      }
+
+      reactor_fd(reactor_fd&& other) noexcept = default;
+      auto operator=(reactor_fd&& other) noexcept -> reactor_fd& {
+         std::swap(reactor_, other.reactor_);
+         std::swap(entry_, other.entry_);
+         return *this;
+      }
+
+      ~reactor_fd() noexcept {
+         if(entry_ != nullptr && entry_->fd_ >= 0) {
+            reactor_->remove(*entry_);
+            ::close(entry_->fd_);
+         }
+      }
+
+      auto fd() const noexcept -> int {
+         return entry_ == nullptr ? -1 : entry_->fd_;
+      }
+
+      auto entry() const noexcept -> io_entry& {
+         return *entry_;
+      }
+
+      auto reactor() const noexcept -> epoll_reactor& {
+         return *reactor_;
+      }
+
+   private:
+      epoll_reactor* reactor_{};
+      std::unique_ptr<io_entry> entry_;
+   };
+
+   inline auto last_error() noexcept -> std::error_code {
+      return std::error_code{errno, std::system_category()};
+   }
+
+   inline auto would_block() noexcept -> bool {
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+   }
+}
+
+E_CORO_NS_END
+
+#endif //E_CORO_EPOLL_REACTOR_H
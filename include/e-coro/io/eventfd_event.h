@@ -0,0 +1,99 @@
+#ifndef E_CORO_EVENTFD_EVENT_H
+#define E_CORO_EVENTFD_EVENT_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/core/result.h>
+#include <e-coro/io/epoll_reactor.h>
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+#include <utility>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+E_CORO_NS_BEGIN
+
+/////////////////////////////////////////////////////////////////////////////
+// An event set from any thread, by a single write to an eventfd, while the
+// consumer awaits it on a reactor, and is resumed by the reactor's loop on
+// its thread; unlike single_consumer_event, whose set() resumes the
+// consumer right there, on the thread of the setter.
+//
+// A set is consumed by the co_await which sees it, and the sets before
+// that are merged into one: it's a wake-up, rather than a count.
+/////////////////////////////////////////////////////////////////////////////
+struct eventfd_event {
+   eventfd_event() noexcept = default;
+
+   static auto open(epoll_reactor& reactor, bool initially_set = false) noexcept
+      -> result<eventfd_event, std::error_code> {
+      int fd = ::eventfd(initially_set ? 1 : 0, EFD_NONBLOCK | EFD_CLOEXEC);
+      if(fd < 0) return unexpected{detail::last_error()};
+      auto [registered, error] = detail::reactor_fd::open(reactor, fd);
+      if(error) return unexpected{error};
+      return eventfd_event{std::move(registered)};
+   }
+
+   // any thread.
+   auto set() const noexcept -> void {
+      std::uint64_t one = 1;
+      // it fails only if it's set so many times already.
+      while(::write(fd_.fd(), &one, sizeof(one)) < 0 && errno == EINTR);
+   }
+
+   // the thread of the reactor.
+   auto reset() noexcept -> void {
+      std::uint64_t value;
+      while(::read(fd_.fd(), &value, sizeof(value)) < 0 && errno == EINTR);
+   }
+
+   struct wait_operation : detail::io_awaiter<wait_operation, false> {
+      explicit wait_operation(eventfd_event& event) noexcept
+         : event_{event}
+      {}
+
+      auto try_perform() noexcept -> bool {
+         while(true) {
+            std::uint64_t value;
+            if(::read(event_.fd_.fd(), &value, sizeof(value)) == sizeof(value)) return true;
+            if(errno == EINTR) continue;
+            if(detail::would_block()) return false;
+            error_ = detail::last_error();
+            return true;
+         }
+      }
+
+      auto entry() noexcept -> detail::io_entry& {
+         return event_.fd_.entry();
+      }
+
+      // set, or why it couldn't be told.
+      auto await_resume() const noexcept -> result<void, std::error_code> {
+         if(error_) return unexpected{error_};
+         return {};
+      }
+
+   private:
+      eventfd_event& event_;
+      std::error_code error_;
+   };
+
+   auto operator co_await() noexcept -> wait_operation {
+      return wait_operation{*this};
+   }
+
+   auto fd() const noexcept -> int {
+      return fd_.fd();
+   }
+
+private:
+   explicit eventfd_event(detail::reactor_fd&& fd) noexcept
+      : fd_{std::move(fd)}
+   {}
+
+   detail::reactor_fd fd_;
+};
+
+E_CORO_NS_END
+
+#endif //E_CORO_EVENTFD_EVENT_H
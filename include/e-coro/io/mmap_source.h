@@ -0,0 +1,283 @@
+#ifndef E_CORO_MMAP_SOURCE_H
+#define E_CORO_MMAP_SOURCE_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/core/result.h>
+#include <e-coro/scheduler/schedule_node.h>
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+E_CORO_NS_BEGIN
+
+namespace detail {
+   struct prefetch_request {
+      const std::byte* begin_;
+      const std::byte* end_;
+      int fd_;
+      std::uint64_t offset_;
+      prefetch_request* next_{};
+      schedule_node node_{};
+      void* queue_{};
+      void (*push_)(void*, schedule_node&) noexcept {};
+   };
+
+   // f(page, resident) for each page of [begin, end), till it gives false;
+   // one mincore per window of pages. A page it couldn't tell about is
+   // taken as not resident.
+   template<typename F>
+   inline auto for_each_page(const std::byte* begin, const std::byte* end, std::size_t page_size, F&& f) noexcept -> void {
+      constexpr std::size_t window = 256;
+      unsigned char pages[window];
+      auto p = reinterpret_cast<std::uintptr_t>(begin) & ~(page_size - 1);
+      auto last = reinterpret_cast<std::uintptr_t>(end);
+      while(p < last) {
+         auto n = std::min<std::size_t>(window, (last - p + page_size - 1) / page_size);
+         bool known = ::mincore(reinterpret_cast<void*>(p), n * page_size, pages) == 0;
+         for(std::size_t i = 0; i < n; ++i) {
+            if(!f(p + i * page_size, known && (pages[i] & 1) != 0)) return;
+         }
+         p += n * page_size;
+      }
+   }
+
+   // the pages of [begin, end) are all in memory.
+   inline auto is_resident(const std::byte* begin, const std::byte* end, std::size_t page_size) noexcept -> bool {
+      bool all = true;
+      for_each_page(begin, end, page_size, [&](std::uintptr_t, bool resident) {
+         return all = resident;
+      });
+      return all;
+   }
+
+   /////////////////////////////////////////////////////////////////////////
+   // The thread taking the page faults instead of the ones awaiting: it
+   // asks the kernel to read the range ahead, then touches whatever is not
+   // resident yet, and resumes the awaiting coroutine once it all is. One
+   // for the process, started on the first prefetch that's not resident.
+   /////////////////////////////////////////////////////////////////////////
+   struct prefetch_thread {
+      static auto instance() -> prefetch_thread& {
+         static prefetch_thread t;
+         return t;
+      }
+
+      prefetch_thread(prefetch_thread const&) = delete;
+      prefetch_thread& operator=(prefetch_thread const&) = delete;
+
+      ~prefetch_thread() noexcept {
+         {
+            std::lock_guard lock{mutex_};
+            stopping_ = true;
+         }
+         wake_up_.notify_one();
+         thread_.join();
+      }
+
+      auto push(prefetch_request& request) noexcept -> void {
+         {
+            std::lock_guard lock{mutex_};
+            request.next_ = nullptr;
+            if(tail_ == nullptr) head_ = &request;
+            else tail_->next_ = &request;
+            tail_ = &request;
+         }
+         wake_up_.notify_one();
+      }
+
+   private:
+      prefetch_thread()
+         : page_size_{static_cast<std::size_t>(::sysconf(_SC_PAGESIZE))}
+         , thread_{[this] { run(); }}
+      {}
+
+      auto pop() noexcept -> prefetch_request* {
+         std::unique_lock lock{mutex_};
+         wake_up_.wait(lock, [this] { return head_ != nullptr || stopping_; });
+         auto request = head_;
+         if(request != nullptr) {
+            head_ = request->next_;
+            if(head_ == nullptr) tail_ = nullptr;
+         }
+         return request;
+      }
+
+      auto load(prefetch_request& request) noexcept -> void {
+         auto begin = reinterpret_cast<std::uintptr_t>(request.begin_) & ~(page_size_ - 1);
+         auto end = reinterpret_cast<std::uintptr_t>(request.end_);
+         ::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+#if defined(__linux__)
+         ::readahead(request.fd_, static_cast<off64_t>(request.offset_), end - reinterpret_cast<std::uintptr_t>(request.begin_));
+#endif
+         // the advice is only a hint; a fault of mine makes sure of it.
+         for_each_page(request.begin_, request.end_, page_size_, [](std::uintptr_t page, bool resident) {
+            if(!resident) (void)*reinterpret_cast<const volatile std::byte*>(page);
+            return true;
+         });
+      }
+
+      auto run() noexcept -> void {
+         while(auto request = pop()) {
+            load(*request);
+            // the request is gone with the awaiter once it's resumed.
+            if(request->push_ != nullptr) {
+               request->push_(request->queue_, request->node_);
+            } else {
+               request->node_.resume();
+            }
+         }
+      }
+
+   private:
+      const std::size_t page_size_;
+      std::mutex mutex_;
+      std::condition_variable wake_up_;
+      prefetch_request* head_{};
+      prefetch_request* tail_{};
+      bool stopping_{false};
+      std::thread thread_;
+   };
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// A read-only file mapped into memory, for random access. Touching a page
+// that's not in memory blocks the thread on a fault, thus a coroutine that's
+// about to touch a range could prefetch it first:
+//
+//    co_await source.prefetch(offset, length);
+//    lookup(source.bytes().subspan(offset, length));
+//
+// which doesn't suspend at all if the range is resident already; otherwise
+// the pages are faulted in by a helper thread, and the coroutine is resumed
+// there, or handed over to a run queue of its own with resume_via(queue).
+/////////////////////////////////////////////////////////////////////////////
+struct mmap_source {
+   static auto open(const char* path) -> result<mmap_source, std::error_code> {
+      int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+      if(fd < 0) return unexpected{std::error_code{errno, std::system_category()}};
+      struct ::stat st;
+      if(::fstat(fd, &st) != 0) {
+         auto error = errno;
+         ::close(fd);
+         return unexpected{std::error_code{error, std::system_category()}};
+      }
+      auto size = static_cast<std::size_t>(st.st_size);
+      void* data = nullptr;
+      // nothing to map, but it's a valid source still.
+      if(size > 0) {
+         data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+         if(data == MAP_FAILED) {
+            auto error = errno;
+            ::close(fd);
+            return unexpected{std::error_code{error, std::system_category()}};
+         }
+      }
+      return mmap_source{fd, static_cast<const std::byte*>(data), size};
+   }
+
+   mmap_source(mmap_source&& other) noexcept
+      : fd_{std::exchange(other.fd_, -1)}
+      , data_{std::exchange(other.data_, nullptr)}
+      , size_{std::exchange(other.size_, 0)}
+      , page_size_{other.page_size_}
+   {}
+
+   mmap_source(mmap_source const&) = delete;
+   mmap_source& operator=(mmap_source const&) = delete;
+
+   ~mmap_source() noexcept {
+      if(data_ != nullptr) ::munmap(const_cast<std::byte*>(data_), size_);
+      if(fd_ >= 0) ::close(fd_);
+   }
+
+   auto bytes() const noexcept -> std::span<const std::byte> {
+      return {data_, size_};
+   }
+
+   auto size() const noexcept -> std::size_t {
+      return size_;
+   }
+
+   // clamped to the end of the file.
+   auto is_resident(std::size_t offset, std::size_t length) const noexcept -> bool {
+      auto [begin, end] = range(offset, length);
+      return begin == end || detail::is_resident(begin, end, page_size_);
+   }
+
+   struct prefetch_operation {
+      auto await_ready() const noexcept -> bool {
+         return request_.begin_ == request_.end_ ||
+                detail::is_resident(request_.begin_, request_.end_, page_size_);
+      }
+
+      auto await_suspend(std::coroutine_handle<> self) noexcept -> void {
+         request_.node_.handle_ = self;
+         detail::prefetch_thread::instance().push(request_);
+      }
+
+      auto await_resume() const noexcept {}
+
+      // hand the awaiting coroutine over to queue once it's resident,
+      // rather than resuming it on the helper thread.
+      template<schedule_queue_concept Q>
+      auto resume_via(Q& queue) & noexcept -> prefetch_operation& {
+         request_.queue_ = std::addressof(queue);
+         request_.push_ = [](void* queue, schedule_node& node) noexcept {
+            static_cast<Q*>(queue)->push(node);
+         };
+         return *this;
+      }
+
+      template<schedule_queue_concept Q>
+      auto resume_via(Q& queue) && noexcept -> prefetch_operation&& {
+         return std::move(resume_via(queue));
+      }
+
+      detail::prefetch_request request_;
+      std::size_t page_size_;
+   };
+
+   [[nodiscard("this is an awaitable")]]
+   auto prefetch(std::size_t offset, std::size_t length) const noexcept -> prefetch_operation {
+      auto [begin, end] = range(offset, length);
+      return prefetch_operation{{begin, end, fd_, static_cast<std::uint64_t>(begin - data_)}, page_size_};
+   }
+
+private:
+   mmap_source(int fd, const std::byte* data, std::size_t size) noexcept
+      : fd_{fd}
+      , data_{data}
+      , size_{size}
+      , page_size_{static_cast<std::size_t>(::sysconf(_SC_PAGESIZE))}
+   {}
+
+   auto range(std::size_t offset, std::size_t length) const noexcept
+      -> std::pair<const std::byte*, const std::byte*> {
+      offset = std::min(offset, size_);
+      length = std::min(length, size_ - offset);
+      return {data_ + offset, data_ + offset + length};
+   }
+
+private:
+   int fd_;
+   const std::byte* data_;
+   std::size_t size_;
+   std::size_t page_size_;
+};
+
+E_CORO_NS_END
+
+#endif //E_CORO_MMAP_SOURCE_H
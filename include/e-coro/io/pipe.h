@@ -0,0 +1,183 @@
+#ifndef E_CORO_PIPE_H
+#define E_CORO_PIPE_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/core/result.h>
+#include <e-coro/io/epoll_reactor.h>
+#include <cerrno>
+#include <cstddef>
+#include <span>
+#include <system_error>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+
+E_CORO_NS_BEGIN
+
+namespace detail {
+   // take a descriptor over, non-blocking.
+   inline auto adopt_fd(epoll_reactor& reactor, int fd) noexcept -> std::pair<reactor_fd, std::error_code> {
+      auto flags = ::fcntl(fd, F_GETFL);
+      if(flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+         auto error = last_error();
+         ::close(fd);
+         return {reactor_fd{}, error};
+      }
+      return reactor_fd::open(reactor, fd);
+   }
+}
+
+struct pipe_writer;
+
+/////////////////////////////////////////////////////////////////////////////
+// The ends of a pipe on an epoll_reactor, made by open_pipe(), or adopted:
+// the stdout of a subprocess for instance. read returns once anything is
+// read, 0 at the end of stream; write returns once all of it is written.
+//
+// Like a socket, a write to a pipe without a reader raises SIGPIPE, unless
+// it's ignored; it fails with EPIPE then.
+/////////////////////////////////////////////////////////////////////////////
+struct pipe_reader {
+   pipe_reader() noexcept = default;
+
+   static auto adopt(epoll_reactor& reactor, int fd) noexcept -> result<pipe_reader, std::error_code> {
+      auto [registered, error] = detail::adopt_fd(reactor, fd);
+      if(error) return unexpected{error};
+      return pipe_reader{std::move(registered)};
+   }
+
+   struct read_operation : detail::io_awaiter<read_operation, false> {
+      read_operation(pipe_reader& reader, std::span<std::byte> buffer) noexcept
+         : reader_{reader}
+         , buffer_{buffer}
+      {}
+
+      auto try_perform() noexcept -> bool {
+         while(true) {
+            auto n = ::read(reader_.fd_.fd(), buffer_.data(), buffer_.size());
+            if(n >= 0) {
+               result_ = static_cast<std::size_t>(n);
+               return true;
+            }
+            if(errno == EINTR) continue;
+            if(detail::would_block()) return false;
+            result_ = unexpected{detail::last_error()};
+            return true;
+         }
+      }
+
+      auto entry() noexcept -> detail::io_entry& {
+         return reader_.fd_.entry();
+      }
+
+      auto await_resume() noexcept -> result<std::size_t, std::error_code> {
+         return std::move(result_);
+      }
+
+   private:
+      pipe_reader& reader_;
+      std::span<std::byte> buffer_;
+      result<std::size_t, std::error_code> result_{std::size_t{0}};
+   };
+
+   [[nodiscard("this is an awaitable")]]
+   auto read(std::span<std::byte> buffer) noexcept -> read_operation {
+      return read_operation{*this, buffer};
+   }
+
+   auto fd() const noexcept -> int {
+      return fd_.fd();
+   }
+
+private:
+   friend auto open_pipe(epoll_reactor&) noexcept -> result<std::pair<pipe_reader, pipe_writer>, std::error_code>;
+
+   explicit pipe_reader(detail::reactor_fd&& fd) noexcept
+      : fd_{std::move(fd)}
+   {}
+
+   detail::reactor_fd fd_;
+};
+
+struct pipe_writer {
+   pipe_writer() noexcept = default;
+
+   static auto adopt(epoll_reactor& reactor, int fd) noexcept -> result<pipe_writer, std::error_code> {
+      auto [registered, error] = detail::adopt_fd(reactor, fd);
+      if(error) return unexpected{error};
+      return pipe_writer{std::move(registered)};
+   }
+
+   struct write_operation : detail::io_awaiter<write_operation, true> {
+      write_operation(pipe_writer& writer, std::span<const std::byte> buffer) noexcept
+         : writer_{writer}
+         , buffer_{buffer}
+      {}
+
+      auto try_perform() noexcept -> bool {
+         while(written_ < buffer_.size()) {
+            auto n = ::write(writer_.fd_.fd(), buffer_.data() + written_, buffer_.size() - written_);
+            if(n >= 0) {
+               written_ += static_cast<std::size_t>(n);
+               continue;
+            }
+            if(errno == EINTR) continue;
+            if(detail::would_block()) return false;
+            error_ = detail::last_error();
+            return true;
+         }
+         return true;
+      }
+
+      auto entry() noexcept -> detail::io_entry& {
+         return writer_.fd_.entry();
+      }
+
+      auto await_resume() noexcept -> result<std::size_t, std::error_code> {
+         if(error_) return unexpected{error_};
+         return written_;
+      }
+
+   private:
+      pipe_writer& writer_;
+      std::span<const std::byte> buffer_;
+      std::size_t written_{0};
+      std::error_code error_;
+   };
+
+   [[nodiscard("this is an awaitable")]]
+   auto write(std::span<const std::byte> buffer) noexcept -> write_operation {
+      return write_operation{*this, buffer};
+   }
+
+   auto fd() const noexcept -> int {
+      return fd_.fd();
+   }
+
+private:
+   friend auto open_pipe(epoll_reactor&) noexcept -> result<std::pair<pipe_reader, pipe_writer>, std::error_code>;
+
+   explicit pipe_writer(detail::reactor_fd&& fd) noexcept
+      : fd_{std::move(fd)}
+   {}
+
+   detail::reactor_fd fd_;
+};
+
+// both ends in this process, a reader and a writer.
+inline auto open_pipe(epoll_reactor& reactor) noexcept -> result<std::pair<pipe_reader, pipe_writer>, std::error_code> {
+   int fds[2];
+   if(::pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0) return unexpected{detail::last_error()};
+   auto [read_end, read_error] = detail::reactor_fd::open(reactor, fds[0]);
+   if(read_error) {
+      ::close(fds[1]);
+      return unexpected{read_error};
+   }
+   auto [write_end, write_error] = detail::reactor_fd::open(reactor, fds[1]);
+   if(write_error) return unexpected{write_error};
+   return std::pair{pipe_reader{std::move(read_end)}, pipe_writer{std::move(write_end)}};
+}
+
+E_CORO_NS_END
+
+#endif //E_CORO_PIPE_H
@@ -0,0 +1,92 @@
+#ifndef E_CORO_SOCKET_ADDRESS_H
+#define E_CORO_SOCKET_ADDRESS_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/core/result.h>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+E_CORO_NS_BEGIN
+
+// an IPv4 or IPv6 address and port.
+struct socket_address {
+   // a numeric address, "127.0.0.1" or "::1" for instance.
+   static auto parse(const char* host, std::uint16_t port) noexcept -> result<socket_address, std::error_code> {
+      socket_address address;
+      auto v4 = reinterpret_cast<::sockaddr_in*>(&address.storage_);
+      if(::inet_pton(AF_INET, host, &v4->sin_addr) == 1) {
+         v4->sin_family = AF_INET;
+         v4->sin_port = htons(port);
+         address.length_ = sizeof(::sockaddr_in);
+         return address;
+      }
+      auto v6 = reinterpret_cast<::sockaddr_in6*>(&address.storage_);
+      if(::inet_pton(AF_INET6, host, &v6->sin6_addr) == 1) {
+         v6->sin6_family = AF_INET6;
+         v6->sin6_port = htons(port);
+         address.length_ = sizeof(::sockaddr_in6);
+         return address;
+      }
+      return unexpected{std::make_error_code(std::errc::invalid_argument)};
+   }
+
+   static auto loopback(std::uint16_t port) noexcept -> socket_address {
+      socket_address address;
+      auto v4 = reinterpret_cast<::sockaddr_in*>(&address.storage_);
+      v4->sin_family = AF_INET;
+      v4->sin_port = htons(port);
+      v4->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      address.length_ = sizeof(::sockaddr_in);
+      return address;
+   }
+
+   auto family() const noexcept -> int {
+      return storage_.ss_family;
+   }
+
+   auto port() const noexcept -> std::uint16_t {
+      if(family() == AF_INET6) {
+         return ntohs(reinterpret_cast<const ::sockaddr_in6*>(&storage_)->sin6_port);
+      }
+      return ntohs(reinterpret_cast<const ::sockaddr_in*>(&storage_)->sin_port);
+   }
+
+   auto data() const noexcept -> const ::sockaddr* {
+      return reinterpret_cast<const ::sockaddr*>(&storage_);
+   }
+
+   auto data() noexcept -> ::sockaddr* {
+      return reinterpret_cast<::sockaddr*>(&storage_);
+   }
+
+   auto size() const noexcept -> ::socklen_t {
+      return length_;
+   }
+
+   // the capacity, for the calls filling it in.
+   auto capacity() noexcept -> ::socklen_t& {
+      length_ = sizeof(storage_);
+      return length_;
+   }
+
+   // as long as filled in.
+   auto resize(::socklen_t length) noexcept -> void {
+      length_ = length;
+   }
+
+   friend auto operator==(socket_address const& lhs, socket_address const& rhs) noexcept -> bool {
+      return lhs.length_ == rhs.length_ && std::memcmp(&lhs.storage_, &rhs.storage_, lhs.length_) == 0;
+   }
+
+private:
+   ::sockaddr_storage storage_{};
+   ::socklen_t length_{0};
+};
+
+E_CORO_NS_END
+
+#endif //E_CORO_SOCKET_ADDRESS_H
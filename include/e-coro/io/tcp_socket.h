@@ -0,0 +1,450 @@
+#ifndef E_CORO_TCP_SOCKET_H
+#define E_CORO_TCP_SOCKET_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/core/result.h>
+#include <e-coro/io/epoll_reactor.h>
+#include <e-coro/io/socket_address.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <system_error>
+#include <utility>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+E_CORO_NS_BEGIN
+
+/////////////////////////////////////////////////////////////////////////////
+// A non-blocking TCP connection on an epoll_reactor. Each I/O is a plain
+// awaiter, which is tried right away, and suspends only if it would block:
+//
+//    auto n = co_await socket.recv(buffer);      // result<size_t, error>
+//    co_await socket.send(chain);                // writev of a chain
+//
+// recv returns once anything is received, 0 at the end of stream; send
+// returns once all of it is sent. A buffer chain is a span of iovecs, the
+// chain itself and the buffers should live till the I/O is done.
+//
+// With enable_zerocopy(), a send of zerocopy_threshold bytes or more is
+// made with MSG_ZEROCOPY: the kernel sends right from the buffers, so the
+// send isn't done until the kernel tells it's done with them, either.
+//
+// At most one recv and one send in flight at a time.
+/////////////////////////////////////////////////////////////////////////////
+struct tcp_socket {
+   constexpr static std::size_t zerocopy_threshold = 16 * 1024;
+
+   tcp_socket() noexcept = default;
+
+   struct connect_operation;
+   struct recv_operation;
+   struct send_operation;
+
+   [[nodiscard("this is an awaitable")]]
+   static auto connect(epoll_reactor& reactor, socket_address const& address) noexcept -> connect_operation;
+
+   [[nodiscard("this is an awaitable")]]
+   auto recv(std::span<std::byte> buffer) noexcept -> recv_operation;
+
+   [[nodiscard("this is an awaitable")]]
+   auto recv(std::span<const ::iovec> chain) noexcept -> recv_operation;
+
+   [[nodiscard("this is an awaitable")]]
+   auto send(std::span<const std::byte> buffer) noexcept -> send_operation;
+
+   [[nodiscard("this is an awaitable")]]
+   auto send(std::span<const ::iovec> chain) noexcept -> send_operation;
+
+   auto enable_zerocopy() noexcept -> std::error_code {
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+      int on = 1;
+      if(::setsockopt(fd(), SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on)) != 0) {
+         return detail::last_error();
+      }
+      zerocopy_ = true;
+      return {};
+#else
+      return std::make_error_code(std::errc::operation_not_supported);
+#endif
+   }
+
+   auto set_no_delay(bool on) noexcept -> std::error_code {
+      int value = on ? 1 : 0;
+      if(::setsockopt(fd(), IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value)) != 0) {
+         return detail::last_error();
+      }
+      return {};
+   }
+
+   // no more sends; the peer gets the end of stream.
+   auto shutdown_send() noexcept -> std::error_code {
+      if(::shutdown(fd(), SHUT_WR) != 0) return detail::last_error();
+      return {};
+   }
+
+   auto local_address() const noexcept -> socket_address {
+      socket_address address;
+      ::getsockname(fd(), address.data(), &address.capacity());
+      return address;
+   }
+
+   auto peer_address() const noexcept -> socket_address {
+      socket_address address;
+      ::getpeername(fd(), address.data(), &address.capacity());
+      return address;
+   }
+
+   auto fd() const noexcept -> int {
+      return fd_.fd();
+   }
+
+private:
+   friend struct tcp_listener;
+
+   explicit tcp_socket(detail::reactor_fd&& fd) noexcept
+      : fd_{std::move(fd)}
+   {}
+
+   // count the sends the kernel is done with.
+   auto reap_zerocopy() noexcept -> void {
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+      alignas(::cmsghdr) char control[CMSG_SPACE(sizeof(::sock_extended_err)) * 4];
+      while(true) {
+         ::msghdr message{};
+         message.msg_control = control;
+         message.msg_controllen = sizeof(control);
+         if(::recvmsg(fd(), &message, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            if(errno == EINTR) continue;
+            break;
+         }
+         for(auto c = CMSG_FIRSTHDR(&message); c != nullptr; c = CMSG_NXTHDR(&message, c)) {
+            if(!(c->cmsg_level == SOL_IP && c->cmsg_type == IP_RECVERR) &&
+               !(c->cmsg_level == SOL_IPV6 && c->cmsg_type == IPV6_RECVERR)) {
+               continue;
+            }
+            ::sock_extended_err error;
+            std::memcpy(&error, CMSG_DATA(c), sizeof(error));
+            if(error.ee_origin == SO_EE_ORIGIN_ZEROCOPY) {
+               // sends [ee_info, ee_data] are done.
+               zerocopy_completed_ += error.ee_data - error.ee_info + 1;
+            }
+         }
+      }
+#endif
+   }
+
+private:
+   detail::reactor_fd fd_;
+   bool zerocopy_{false};
+   // MSG_ZEROCOPY sends made, and the ones the kernel is done with.
+   std::uint32_t zerocopy_sent_{0};
+   std::uint32_t zerocopy_completed_{0};
+};
+
+struct tcp_socket::connect_operation : detail::io_awaiter<connect_operation, true> {
+   connect_operation(epoll_reactor& reactor, socket_address const& address) noexcept
+      : reactor_{reactor}
+      , address_{address}
+   {}
+
+   auto try_perform() noexcept -> bool {
+      if(!started_) {
+         started_ = true;
+         int fd = ::socket(address_.family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+         if(fd < 0) return fail(detail::last_error());
+         auto [registered, error] = detail::reactor_fd::open(reactor_, fd);
+         socket_ = tcp_socket{std::move(registered)};
+         if(error) return fail(error);
+         if(::connect(fd, address_.data(), address_.size()) == 0) return true;
+         if(errno != EINPROGRESS && errno != EINTR) return fail(detail::last_error());
+         return false;
+      }
+      int error = 0;
+      ::socklen_t length = sizeof(error);
+      if(::getsockopt(socket_.fd(), SOL_SOCKET, SO_ERROR, &error, &length) != 0) {
+         return fail(detail::last_error());
+      }
+      if(error != 0) return fail(std::error_code{error, std::system_category()});
+      // a socket not connected yet is writable, too.
+      socket_address peer;
+      return ::getpeername(socket_.fd(), peer.data(), &peer.capacity()) == 0;
+   }
+
+   auto entry() noexcept -> detail::io_entry& {
+      return socket_.fd_.entry();
+   }
+
+   auto await_resume() noexcept -> result<tcp_socket, std::error_code> {
+      if(error_) return unexpected{error_};
+      return std::move(socket_);
+   }
+
+private:
+   auto fail(std::error_code error) noexcept -> bool {
+      error_ = error;
+      return true;
+   }
+
+   epoll_reactor& reactor_;
+   socket_address address_;
+   tcp_socket socket_;
+   std::error_code error_;
+   bool started_{false};
+};
+
+struct tcp_socket::recv_operation : detail::io_awaiter<recv_operation, false> {
+   recv_operation(tcp_socket& socket, std::span<std::byte> buffer) noexcept
+      : socket_{socket}
+      , single_{buffer.data(), buffer.size()}
+   {}
+
+   recv_operation(tcp_socket& socket, std::span<const ::iovec> chain) noexcept
+      : socket_{socket}
+      , chain_{chain}
+   {}
+
+   auto try_perform() noexcept -> bool {
+      while(true) {
+         auto n = chain_.empty()
+            ? ::recv(socket_.fd(), single_.iov_base, single_.iov_len, 0)
+            : ::readv(socket_.fd(), chain_.data(), static_cast<int>(std::min<std::size_t>(chain_.size(), IOV_MAX)));
+         if(n >= 0) {
+            result_ = static_cast<std::size_t>(n);
+            return true;
+         }
+         if(errno == EINTR) continue;
+         if(detail::would_block()) return false;
+         result_ = unexpected{detail::last_error()};
+         return true;
+      }
+   }
+
+   auto entry() noexcept -> detail::io_entry& {
+      return socket_.fd_.entry();
+   }
+
+   auto await_resume() noexcept -> result<std::size_t, std::error_code> {
+      return std::move(result_);
+   }
+
+private:
+   tcp_socket& socket_;
+   ::iovec single_{};
+   std::span<const ::iovec> chain_;
+   result<std::size_t, std::error_code> result_{std::size_t{0}};
+};
+
+struct tcp_socket::send_operation : detail::io_awaiter<send_operation, true> {
+   send_operation(tcp_socket& socket, std::span<const std::byte> buffer) noexcept
+      : socket_{socket}
+      , single_{const_cast<std::byte*>(buffer.data()), buffer.size()}
+      , remaining_{buffer.size()}
+   {}
+
+   send_operation(tcp_socket& socket, std::span<const ::iovec> chain) noexcept
+      : socket_{socket}
+      , chain_{chain} {
+      for(auto& iov : chain) remaining_ += iov.iov_len;
+   }
+
+   auto try_perform() noexcept -> bool {
+      while(remaining_ > 0) {
+         if(!send_some()) return false;
+         if(error_) return true;
+      }
+      // the buffers are still the kernel's, till it says they aren't.
+      if(socket_.zerocopy_completed_ != socket_.zerocopy_sent_) {
+         socket_.reap_zerocopy();
+         return socket_.zerocopy_completed_ == socket_.zerocopy_sent_;
+      }
+      return true;
+   }
+
+   auto entry() noexcept -> detail::io_entry& {
+      return socket_.fd_.entry();
+   }
+
+   auto await_resume() noexcept -> result<std::size_t, std::error_code> {
+      if(error_) return unexpected{error_};
+      return sent_;
+   }
+
+private:
+   constexpr static std::size_t max_window = 64;
+
+   auto chain() const noexcept -> std::span<const ::iovec> {
+      return chain_.empty() ? std::span<const ::iovec>{&single_, 1} : chain_;
+   }
+
+   // false if it would block.
+   auto send_some() noexcept -> bool {
+      auto chain = this->chain();
+      ::iovec window[max_window];
+      std::size_t n = 0;
+      for(auto i = index_; i < chain.size() && n < max_window; ++i, ++n) {
+         window[n] = chain[i];
+         if(i == index_) {
+            window[n].iov_base = static_cast<std::byte*>(window[n].iov_base) + offset_;
+            window[n].iov_len -= offset_;
+         }
+      }
+      ::msghdr message{};
+      message.msg_iov = window;
+      message.msg_iovlen = n;
+
+      int flags = MSG_NOSIGNAL;
+#if defined(MSG_ZEROCOPY)
+      bool zerocopy = socket_.zerocopy_ && remaining_ >= tcp_socket::zerocopy_threshold;
+      if(zerocopy) flags |= MSG_ZEROCOPY;
+#endif
+      auto sent = ::sendmsg(socket_.fd(), &message, flags);
+#if defined(MSG_ZEROCOPY)
+      // out of the memory to pin the pages with, copy it then.
+      if(sent < 0 && zerocopy && errno == ENOBUFS) {
+         zerocopy = false;
+         sent = ::sendmsg(socket_.fd(), &message, MSG_NOSIGNAL);
+      }
+      if(sent >= 0 && zerocopy) ++socket_.zerocopy_sent_;
+#endif
+      if(sent < 0) {
+         if(errno == EINTR) return true;
+         if(detail::would_block()) return false;
+         error_ = detail::last_error();
+         return true;
+      }
+      advance(static_cast<std::size_t>(sent));
+      return true;
+   }
+
+   auto advance(std::size_t n) noexcept -> void {
+      auto chain = this->chain();
+      sent_ += n;
+      remaining_ -= n;
+      while(n > 0) {
+         auto left = chain[index_].iov_len - offset_;
+         if(n < left) {
+            offset_ += n;
+            break;
+         }
+         n -= left;
+         ++index_;
+         offset_ = 0;
+      }
+   }
+
+   tcp_socket& socket_;
+   ::iovec single_{};
+   std::span<const ::iovec> chain_;
+   std::size_t index_{0};
+   std::size_t offset_{0};
+   std::size_t remaining_{0};
+   std::size_t sent_{0};
+   std::error_code error_;
+};
+
+inline auto tcp_socket::connect(epoll_reactor& reactor, socket_address const& address) noexcept -> connect_operation {
+   return connect_operation{reactor, address};
+}
+
+inline auto tcp_socket::recv(std::span<std::byte> buffer) noexcept -> recv_operation {
+   return recv_operation{*this, buffer};
+}
+
+inline auto tcp_socket::recv(std::span<const ::iovec> chain) noexcept -> recv_operation {
+   return recv_operation{*this, chain};
+}
+
+inline auto tcp_socket::send(std::span<const std::byte> buffer) noexcept -> send_operation {
+   return send_operation{*this, buffer};
+}
+
+inline auto tcp_socket::send(std::span<const ::iovec> chain) noexcept -> send_operation {
+   return send_operation{*this, chain};
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// A listening TCP socket; each co_await accept() is a connection, or the
+// error which failed it.
+/////////////////////////////////////////////////////////////////////////////
+struct tcp_listener {
+   static auto listen(epoll_reactor& reactor, socket_address const& address, int backlog = SOMAXCONN) noexcept
+      -> result<tcp_listener, std::error_code> {
+      int fd = ::socket(address.family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      if(fd < 0) return unexpected{detail::last_error()};
+      int on = 1;
+      ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+      if(::bind(fd, address.data(), address.size()) != 0 || ::listen(fd, backlog) != 0) {
+         auto error = detail::last_error();
+         ::close(fd);
+         return unexpected{error};
+      }
+      auto [registered, error] = detail::reactor_fd::open(reactor, fd);
+      if(error) return unexpected{error};
+      return tcp_listener{std::move(registered)};
+   }
+
+   struct accept_operation : detail::io_awaiter<accept_operation, false> {
+      explicit accept_operation(tcp_listener& listener) noexcept
+         : listener_{listener}
+      {}
+
+      auto try_perform() noexcept -> bool {
+         while(true) {
+            int fd = ::accept4(listener_.fd_.fd(), nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if(fd >= 0) {
+               auto [registered, error] = detail::reactor_fd::open(listener_.fd_.reactor(), fd);
+               socket_ = tcp_socket{std::move(registered)};
+               error_ = error;
+               return true;
+            }
+            if(errno == EINTR || errno == ECONNABORTED) continue;
+            if(detail::would_block()) return false;
+            error_ = detail::last_error();
+            return true;
+         }
+      }
+
+      auto entry() noexcept -> detail::io_entry& {
+         return listener_.fd_.entry();
+      }
+
+      auto await_resume() noexcept -> result<tcp_socket, std::error_code> {
+         if(error_) return unexpected{error_};
+         return std::move(socket_);
+      }
+
+   private:
+      tcp_listener& listener_;
+      tcp_socket socket_;
+      std::error_code error_;
+   };
+
+   [[nodiscard("this is an awaitable")]]
+   auto accept() noexcept -> accept_operation {
+      return accept_operation{*this};
+   }
+
+   auto local_address() const noexcept -> socket_address {
+      socket_address address;
+      ::getsockname(fd_.fd(), address.data(), &address.capacity());
+      return address;
+   }
+
+private:
+   explicit tcp_listener(detail::reactor_fd&& fd) noexcept
+      : fd_{std::move(fd)}
+   {}
+
+   detail::reactor_fd fd_;
+};
+
+E_CORO_NS_END
+
+#endif //E_CORO_TCP_SOCKET_H
@@ -0,0 +1,281 @@
+#ifndef E_CORO_UDP_SOCKET_H
+#define E_CORO_UDP_SOCKET_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/core/result.h>
+#include <e-coro/io/epoll_reactor.h>
+#include <e-coro/io/socket_address.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+#include <system_error>
+#include <utility>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+E_CORO_NS_BEGIN
+
+// a datagram to send, or to receive into.
+struct udp_message {
+   std::span<std::byte> buffer_;
+   // where it's from, or to.
+   socket_address address_;
+   // received bytes.
+   std::size_t size_{};
+   // received: the size of each datagram coalesced by GRO, 0 if it's one;
+   // to send: split it into datagrams of this size by GSO, 0 if it's one.
+   std::uint16_t segment_size_{};
+   // received: it didn't fit into the buffer.
+   bool truncated_{false};
+};
+
+// what a send_batch got done: the messages before error_, all of them if
+// there's none.
+struct udp_send_result {
+   std::size_t sent_{};
+   std::error_code error_{};
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// A non-blocking UDP socket on an epoll_reactor, which receives and sends
+// datagrams in batches, by recvmmsg and sendmmsg: a coroutine is resumed
+// once per batch, rather than once per datagram.
+//
+//    udp_message messages[32];                 // buffers set up already
+//    auto n = co_await socket.recv_batch(messages);
+//
+// recv_batch returns once one datagram at least is received, with as many
+// as there are, up to max_batch; send_batch returns once all are sent, or
+// one fails, with how many were sent before it.
+// With GRO enabled, the kernel could coalesce datagrams of a flow into one
+// message, of segment_size_ each; a message with a segment_size_ is sent
+// as a train of datagrams of that size, by GSO.
+//
+// At most one recv_batch and one send_batch in flight at a time.
+/////////////////////////////////////////////////////////////////////////////
+struct udp_socket {
+   constexpr static std::size_t max_batch = 64;
+
+   udp_socket() noexcept = default;
+
+   static auto open(epoll_reactor& reactor, socket_address const& address) noexcept
+      -> result<udp_socket, std::error_code> {
+      std::unique_ptr<scratch> recv_scratch{new(std::nothrow) scratch};
+      std::unique_ptr<scratch> send_scratch{new(std::nothrow) scratch};
+      if(recv_scratch == nullptr || send_scratch == nullptr) {
+         return unexpected{std::make_error_code(std::errc::not_enough_memory)};
+      }
+      int fd = ::socket(address.family(), SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      if(fd < 0) return unexpected{detail::last_error()};
+      if(::bind(fd, address.data(), address.size()) != 0) {
+         auto error = detail::last_error();
+         ::close(fd);
+         return unexpected{error};
+      }
+      auto [registered, error] = detail::reactor_fd::open(reactor, fd);
+      if(error) return unexpected{error};
+      return udp_socket{std::move(registered), std::move(recv_scratch), std::move(send_scratch)};
+   }
+
+   struct recv_batch_operation;
+   struct send_batch_operation;
+
+   [[nodiscard("this is an awaitable")]]
+   auto recv_batch(std::span<udp_message> messages) noexcept -> recv_batch_operation;
+
+   [[nodiscard("this is an awaitable")]]
+   auto send_batch(std::span<const udp_message> messages) noexcept -> send_batch_operation;
+
+   auto enable_gro() noexcept -> std::error_code {
+#if defined(UDP_GRO)
+      int on = 1;
+      if(::setsockopt(fd(), SOL_UDP, UDP_GRO, &on, sizeof(on)) != 0) {
+         return detail::last_error();
+      }
+      return {};
+#else
+      return std::make_error_code(std::errc::operation_not_supported);
+#endif
+   }
+
+   auto local_address() const noexcept -> socket_address {
+      socket_address address;
+      ::getsockname(fd(), address.data(), &address.capacity());
+      return address;
+   }
+
+   auto fd() const noexcept -> int {
+      return fd_.fd();
+   }
+
+private:
+   constexpr static std::size_t control_size = CMSG_SPACE(sizeof(int));
+
+   // the headers of a batch, allocated once for the socket.
+   struct scratch {
+      ::mmsghdr headers_[max_batch];
+      ::iovec iovs_[max_batch];
+      alignas(::cmsghdr) char controls_[max_batch][control_size];
+   };
+
+   udp_socket(detail::reactor_fd&& fd, std::unique_ptr<scratch> recv_scratch, std::unique_ptr<scratch> send_scratch) noexcept
+      : fd_{std::move(fd)}
+      , recv_scratch_{std::move(recv_scratch)}
+      , send_scratch_{std::move(send_scratch)}
+   {}
+
+private:
+   detail::reactor_fd fd_;
+   std::unique_ptr<scratch> recv_scratch_;
+   std::unique_ptr<scratch> send_scratch_;
+};
+
+struct udp_socket::recv_batch_operation : detail::io_awaiter<recv_batch_operation, false> {
+   recv_batch_operation(udp_socket& socket, std::span<udp_message> messages) noexcept
+      : socket_{socket}
+      , messages_{messages.first(std::min(messages.size(), max_batch))}
+   {}
+
+   auto try_perform() noexcept -> bool {
+      if(messages_.empty()) return true;
+      auto& s = *socket_.recv_scratch_;
+      for(std::size_t i = 0; i < messages_.size(); ++i) {
+         auto& message = messages_[i];
+         s.iovs_[i] = ::iovec{message.buffer_.data(), message.buffer_.size()};
+         auto& header = s.headers_[i].msg_hdr;
+         header = ::msghdr{};
+         header.msg_name = message.address_.data();
+         header.msg_namelen = message.address_.capacity();
+         header.msg_iov = &s.iovs_[i];
+         header.msg_iovlen = 1;
+         header.msg_control = s.controls_[i];
+         header.msg_controllen = control_size;
+      }
+      while(true) {
+         auto n = ::recvmmsg(socket_.fd(), s.headers_, static_cast<unsigned>(messages_.size()), MSG_DONTWAIT, nullptr);
+         if(n > 0) {
+            for(std::size_t i = 0; i < static_cast<std::size_t>(n); ++i) {
+               fill(messages_[i], s.headers_[i]);
+            }
+            result_ = static_cast<std::size_t>(n);
+            return true;
+         }
+         if(n < 0 && errno == EINTR) continue;
+         if(n < 0 && detail::would_block()) return false;
+         if(n < 0) result_ = unexpected{detail::last_error()};
+         return true;
+      }
+   }
+
+   auto entry() noexcept -> detail::io_entry& {
+      return socket_.fd_.entry();
+   }
+
+   // the number of messages received.
+   auto await_resume() noexcept -> result<std::size_t, std::error_code> {
+      return std::move(result_);
+   }
+
+private:
+   static auto fill(udp_message& message, ::mmsghdr& received) noexcept -> void {
+      auto& header = received.msg_hdr;
+      message.size_ = received.msg_len;
+      message.address_.resize(header.msg_namelen);
+      message.truncated_ = (header.msg_flags & MSG_TRUNC) != 0;
+      message.segment_size_ = 0;
+#if defined(UDP_GRO)
+      for(auto c = CMSG_FIRSTHDR(&header); c != nullptr; c = CMSG_NXTHDR(&header, c)) {
+         if(c->cmsg_level == SOL_UDP && c->cmsg_type == UDP_GRO) {
+            int segment_size;
+            std::memcpy(&segment_size, CMSG_DATA(c), sizeof(segment_size));
+            message.segment_size_ = static_cast<std::uint16_t>(segment_size);
+         }
+      }
+#endif
+   }
+
+   udp_socket& socket_;
+   std::span<udp_message> messages_;
+   result<std::size_t, std::error_code> result_{std::size_t{0}};
+};
+
+struct udp_socket::send_batch_operation : detail::io_awaiter<send_batch_operation, true> {
+   send_batch_operation(udp_socket& socket, std::span<const udp_message> messages) noexcept
+      : socket_{socket}
+      , messages_{messages}
+   {}
+
+   auto try_perform() noexcept -> bool {
+      while(sent_ < messages_.size()) {
+         auto batch = messages_.subspan(sent_, std::min(messages_.size() - sent_, max_batch));
+         auto& s = *socket_.send_scratch_;
+         for(std::size_t i = 0; i < batch.size(); ++i) {
+            prepare(batch[i], s, i);
+         }
+         auto n = ::sendmmsg(socket_.fd(), s.headers_, static_cast<unsigned>(batch.size()), MSG_DONTWAIT | MSG_NOSIGNAL);
+         if(n > 0) {
+            sent_ += static_cast<std::size_t>(n);
+            continue;
+         }
+         if(n < 0 && errno == EINTR) continue;
+         if(n < 0 && detail::would_block()) return false;
+         error_ = n < 0 ? detail::last_error() : std::make_error_code(std::errc::io_error);
+         return true;
+      }
+      return true;
+   }
+
+   auto entry() noexcept -> detail::io_entry& {
+      return socket_.fd_.entry();
+   }
+
+   auto await_resume() const noexcept -> udp_send_result {
+      return {sent_, error_};
+   }
+
+private:
+   static auto prepare(udp_message const& message, scratch& s, std::size_t i) noexcept -> void {
+      s.iovs_[i] = ::iovec{message.buffer_.data(), message.buffer_.size()};
+      auto& header = s.headers_[i].msg_hdr;
+      header = ::msghdr{};
+      header.msg_name = const_cast<::sockaddr*>(message.address_.data());
+      header.msg_namelen = message.address_.size();
+      header.msg_iov = &s.iovs_[i];
+      header.msg_iovlen = 1;
+#if defined(UDP_SEGMENT)
+      if(message.segment_size_ > 0) {
+         header.msg_control = s.controls_[i];
+         header.msg_controllen = CMSG_SPACE(sizeof(std::uint16_t));
+         auto c = CMSG_FIRSTHDR(&header);
+         c->cmsg_level = SOL_UDP;
+         c->cmsg_type = UDP_SEGMENT;
+         c->cmsg_len = CMSG_LEN(sizeof(std::uint16_t));
+         std::memcpy(CMSG_DATA(c), &message.segment_size_, sizeof(std::uint16_t));
+      }
+#endif
+   }
+
+   udp_socket& socket_;
+   std::span<const udp_message> messages_;
+   std::size_t sent_{0};
+   std::error_code error_;
+};
+
+inline auto udp_socket::recv_batch(std::span<udp_message> messages) noexcept -> recv_batch_operation {
+   return recv_batch_operation{*this, messages};
+}
+
+inline auto udp_socket::send_batch(std::span<const udp_message> messages) noexcept -> send_batch_operation {
+   return send_batch_operation{*this, messages};
+}
+
+E_CORO_NS_END
+
+#endif //E_CORO_UDP_SOCKET_H
@@ -0,0 +1,352 @@
+#ifndef E_CORO_ACTOR_H
+#define E_CORO_ACTOR_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/core/task.h>
+#include <e-coro/debug/frame_stats.h>
+#include <e-coro/scheduler/mpsc_queue.h>
+#include <e-coro/scheduler/schedule_node.h>
+#include <e-coro/scheduler/static_thread_pool.h>
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+E_CORO_NS_BEGIN
+
+namespace detail {
+   // the coroutine running the body of an actor, parked till the first message.
+   struct actor_loop {
+      struct promise_type : frame_stats_hooks {
+         auto get_return_object() noexcept -> actor_loop {
+            return actor_loop{std::coroutine_handle<promise_type>::from_promise(*this)};
+         }
+         auto initial_suspend() noexcept { return std::suspend_always{}; }
+         auto final_suspend() noexcept {
+            // once it's suspended for good, as the frame could be destroyed
+            // by whoever is told.
+            struct awaiter : std::suspend_always {
+               auto await_suspend(std::coroutine_handle<promise_type> h) noexcept -> void {
+                  auto& promise = h.promise();
+                  promise.on_done_(promise.context_);
+               }
+            };
+            return awaiter{};
+         }
+         auto return_void() noexcept {}
+
+         void* context_{};
+         void (*on_done_)(void*) noexcept {};
+      };
+
+      std::coroutine_handle<promise_type> handle_;
+   };
+
+   template<typename R>
+   struct actor_reply {
+      auto take() noexcept -> R {
+         return std::move(*value_);
+      }
+
+      std::optional<R> value_;
+   };
+
+   template<>
+   struct actor_reply<void> {
+      auto take() noexcept -> void {}
+   };
+}
+
+template<typename STATE, typename MESSAGE, typename REPLY, schedule_queue_concept S>
+struct actor;
+
+/////////////////////////////////////////////////////////////////////////////
+// A message in a mailbox, along with the coroutine asking, suspended till
+// it's replied to. It lives in the awaiter of the asking coroutine, thus
+// in its frame: neither sending nor replying allocates.
+/////////////////////////////////////////////////////////////////////////////
+template<typename MESSAGE, typename REPLY>
+struct actor_request {
+   explicit actor_request(MESSAGE&& message) noexcept(std::is_nothrow_move_constructible_v<MESSAGE>)
+      : message_{std::move(message)}
+   {}
+
+   auto message() noexcept -> MESSAGE& {
+      return message_;
+   }
+
+   // once per request; the request is gone afterwards.
+   template<typename ... ARGS>
+   auto reply(ARGS&& ... args) noexcept -> void {
+      if constexpr(!std::is_void_v<REPLY>) {
+         reply_.value_.emplace(std::forward<ARGS>(args)...);
+      }
+      release();
+   }
+
+private:
+   template<typename, typename, typename, schedule_queue_concept>
+   friend struct actor;
+   template<typename>
+   friend struct basic_mpsc_queue;
+
+   auto release() noexcept -> void {
+      push_(queue_, sender_);
+   }
+
+   actor_request* next_{};
+   MESSAGE message_;
+   detail::actor_reply<REPLY> reply_;
+   schedule_node sender_;
+   void* queue_{};
+   void (*push_)(void*, schedule_node&) noexcept {};
+   // asked by stop() rather than ask().
+   bool stop_{false};
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// An actor owns a STATE, and a mailbox of MESSAGEs to be handled one at a
+// time by a single coroutine, its body, which loops over them:
+//
+//    actor<int, int, int> counter{pool, 0, [](auto& self, int& sum) -> task<> {
+//       while(auto request = co_await self.next()) {
+//          request->reply(sum += request->message());
+//       }
+//    }};
+//
+//    auto sum = co_await counter.ask(42);       // from anywhere
+//    co_await counter.stop();
+//
+// The body runs on one thread of the scheduler at a time: an actor is
+// handed over to the scheduler by the message that finds it idle, and
+// next() takes the messages there already without suspending, up to
+// quantum of them; then it goes to the back of the run queue, so that
+// a busy actor doesn't starve the others of a worker.
+//
+// ask() is an awaiter, the request is part of it, and the asking coroutine
+// is resumed on the scheduler once it's replied to, or on a run queue of
+// its own with resume_via(queue). Every request is to be replied to, once.
+//
+// next() gives nullptr once stop() is handled, the messages before it are
+// handled first; the body is to return then, and stop() to resume. The
+// actor is to be destroyed once stopped, or else idle with no one asking.
+/////////////////////////////////////////////////////////////////////////////
+template<typename STATE, typename MESSAGE, typename REPLY = void, schedule_queue_concept S = static_thread_pool>
+struct actor {
+   using request = actor_request<MESSAGE, REPLY>;
+
+   // F is invoked once, as body(actor&, STATE&), to start the loop.
+   template<typename F>
+   actor(S& scheduler, STATE state, F&& body, std::size_t quantum = 64)
+      : scheduler_{scheduler}
+      , state_{std::move(state)}
+      , quantum_{std::max<std::size_t>(quantum, 1)} {
+      auto loop = run<std::decay_t<F>>(*this, std::forward<F>(body)).handle_;
+      loop.promise().context_ = this;
+      loop.promise().on_done_ = [](void* self) noexcept {
+         auto stop = static_cast<actor*>(self)->stop_;
+         if(stop != nullptr) stop->release();
+      };
+      loop_ = loop;
+      run_node_.handle_ = loop;
+   }
+
+   actor(actor const&) = delete;
+   actor& operator=(actor const&) = delete;
+
+   ~actor() {
+      loop_.destroy();
+   }
+
+   struct ask_operation;
+   struct stop_operation;
+   struct next_operation;
+
+   [[nodiscard("this is an awaitable")]]
+   auto ask(MESSAGE message) noexcept(std::is_nothrow_move_constructible_v<MESSAGE>) -> ask_operation;
+
+   [[nodiscard("this is an awaitable")]]
+   auto stop() noexcept(std::is_nothrow_default_constructible_v<MESSAGE>) -> stop_operation;
+
+   // the body only.
+   [[nodiscard("this is an awaitable")]]
+   auto next() noexcept -> next_operation;
+
+   // not to be touched by others while it's running.
+   auto state() noexcept -> STATE& {
+      return state_;
+   }
+
+private:
+   template<typename BODY>
+   static auto run(actor& self, BODY body) -> detail::actor_loop {
+      co_await body(self, self.state_);
+   }
+
+   auto post(request& r) noexcept -> void {
+      mailbox_.push(r);
+      // counted once it's there to be popped.
+      if(count_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+         scheduler_.push(run_node_);
+      }
+   }
+
+   auto attach(request& r) noexcept -> void {
+      r.queue_ = std::addressof(scheduler_);
+      r.push_ = [](void* queue, schedule_node& node) noexcept {
+         static_cast<S*>(queue)->push(node);
+      };
+   }
+
+private:
+   S& scheduler_;
+   STATE state_;
+   std::size_t quantum_;
+   std::coroutine_handle<> loop_;
+   // resumes the body, suspended in next().
+   schedule_node run_node_;
+   // the messages posted and not done with yet; it's in the run queue, or
+   // running, as long as it's not 0.
+   alignas(64) std::atomic<std::size_t> count_{0};
+   basic_mpsc_queue<request> mailbox_;
+   // the consumer only, the body: the messages taken in this quantum, and
+   // whether the last one is still counted.
+   std::size_t taken_{0};
+   bool holding_{false};
+   request* stop_{};
+};
+
+template<typename STATE, typename MESSAGE, typename REPLY, schedule_queue_concept S>
+struct actor<STATE, MESSAGE, REPLY, S>::ask_operation {
+   ask_operation(actor& self, MESSAGE&& message) noexcept(std::is_nothrow_move_constructible_v<MESSAGE>)
+      : self_{self}
+      , request_{std::move(message)} {
+      self_.attach(request_);
+   }
+
+   auto await_ready() const noexcept -> bool {
+      return false;
+   }
+
+   auto await_suspend(std::coroutine_handle<> h) noexcept -> void {
+      request_.sender_.handle_ = h;
+      self_.post(request_);
+   }
+
+   auto await_resume() noexcept -> REPLY {
+      return request_.reply_.take();
+   }
+
+   // hand the asking coroutine over to queue once it's replied to, rather
+   // than to the scheduler of the actor.
+   template<schedule_queue_concept Q>
+   auto resume_via(Q& queue) & noexcept -> ask_operation& {
+      request_.queue_ = std::addressof(queue);
+      request_.push_ = [](void* queue, schedule_node& node) noexcept {
+         static_cast<Q*>(queue)->push(node);
+      };
+      return *this;
+   }
+
+   template<schedule_queue_concept Q>
+   auto resume_via(Q& queue) && noexcept -> ask_operation&& {
+      return std::move(resume_via(queue));
+   }
+
+protected:
+   actor& self_;
+   request request_;
+};
+
+template<typename STATE, typename MESSAGE, typename REPLY, schedule_queue_concept S>
+struct actor<STATE, MESSAGE, REPLY, S>::stop_operation : ask_operation {
+   explicit stop_operation(actor& self) noexcept(std::is_nothrow_default_constructible_v<MESSAGE>)
+      : ask_operation{self, MESSAGE{}} {
+      this->request_.stop_ = true;
+   }
+
+   auto await_resume() noexcept -> void {}
+};
+
+template<typename STATE, typename MESSAGE, typename REPLY, schedule_queue_concept S>
+struct actor<STATE, MESSAGE, REPLY, S>::next_operation {
+   explicit next_operation(actor& self) noexcept
+      : self_{self}
+   {}
+
+   auto await_ready() noexcept -> bool {
+      auto& self = self_;
+      if(self.holding_) {
+         // done with the last one; if it's the only one counted, the actor
+         // is to be given up, which is once it's suspended.
+         if(self.count_.load(std::memory_order_acquire) == 1) return false;
+         self.count_.fetch_sub(1, std::memory_order_acq_rel);
+         self.holding_ = false;
+      }
+      // one is counted at least, thus there to be popped; unless the
+      // quantum is used up.
+      return self.taken_ < self.quantum_;
+   }
+
+   // once it's handed over, the body could be resumed on another thread
+   // before this returns, so the frame, this included, is not to be touched.
+   auto await_suspend(std::coroutine_handle<> h) noexcept -> bool {
+      auto& self = self_;
+      self.run_node_.handle_ = h;
+      auto taken = std::exchange(self.taken_, 0);
+      if(self.holding_) {
+         self.holding_ = false;
+         // idle, till a poster finds it 0 and gets it scheduled again.
+         if(self.count_.fetch_sub(1, std::memory_order_acq_rel) == 1) return true;
+         // one more came in meanwhile.
+         if(taken < self.quantum_) {
+            self.taken_ = taken;
+            return false;
+         }
+      }
+      // the quantum is used up: to the back of the run queue.
+      self.scheduler_.push(self.run_node_);
+      return true;
+   }
+
+   // nullptr once it's stopped.
+   auto await_resume() noexcept -> request* {
+      auto& self = self_;
+      auto r = self.mailbox_.pop();
+      self.holding_ = true;
+      ++self.taken_;
+      if(r->stop_) {
+         self.stop_ = r;
+         return nullptr;
+      }
+      return r;
+   }
+
+private:
+   actor& self_;
+};
+
+template<typename STATE, typename MESSAGE, typename REPLY, schedule_queue_concept S>
+inline auto actor<STATE, MESSAGE, REPLY, S>::ask(MESSAGE message) noexcept(std::is_nothrow_move_constructible_v<MESSAGE>)
+   -> ask_operation {
+   return ask_operation{*this, std::move(message)};
+}
+
+template<typename STATE, typename MESSAGE, typename REPLY, schedule_queue_concept S>
+inline auto actor<STATE, MESSAGE, REPLY, S>::stop() noexcept(std::is_nothrow_default_constructible_v<MESSAGE>)
+   -> stop_operation {
+   return stop_operation{*this};
+}
+
+template<typename STATE, typename MESSAGE, typename REPLY, schedule_queue_concept S>
+inline auto actor<STATE, MESSAGE, REPLY, S>::next() noexcept -> next_operation {
+   return next_operation{*this};
+}
+
+E_CORO_NS_END
+
+#endif //E_CORO_ACTOR_H
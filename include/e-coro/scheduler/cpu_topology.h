@@ -0,0 +1,141 @@
+#ifndef E_CORO_CPU_TOPOLOGY_H
+#define E_CORO_CPU_TOPOLOGY_H
+
+#include <e-coro/e_coro_ns.h>
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+E_CORO_NS_BEGIN
+
+/////////////////////////////////////////////////////////////////////////////
+// The CPUs this process may run on, grouped by NUMA node. On Linux it's read
+// from /sys/devices/system/node, of the nodes listed online there, whose
+// ids could have gaps; anywhere else, or if that's not there, all CPUs are
+// taken as a single node.
+/////////////////////////////////////////////////////////////////////////////
+struct cpu_topology {
+   struct node {
+      std::size_t id_;
+      std::vector<std::size_t> cpus_;
+   };
+
+   // sysfs_node is for tests to fake the system with.
+   static auto detect(std::string const& sysfs_node = "/sys/devices/system/node") -> cpu_topology {
+      cpu_topology topology;
+#if defined(__linux__)
+      cpu_set_t allowed;
+      CPU_ZERO(&allowed);
+      bool has_mask = ::sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+      auto is_allowed = [&](std::size_t cpu) {
+         return !has_mask || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed));
+      };
+
+      // the same format as the cpu lists, "0,2-3" for instance.
+      for(auto id : parse_cpu_list(read_line(sysfs_node + "/online"))) {
+         node n{id, {}};
+         for(auto cpu : parse_cpu_list(read_line(sysfs_node + "/node" + std::to_string(id) + "/cpulist"))) {
+            if(is_allowed(cpu)) n.cpus_.push_back(cpu);
+         }
+         if(!n.cpus_.empty()) topology.nodes_.push_back(std::move(n));
+      }
+
+      if(topology.nodes_.empty() && has_mask) {
+         node n{0, {}};
+         for(std::size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if(CPU_ISSET(cpu, &allowed)) n.cpus_.push_back(cpu);
+         }
+         if(!n.cpus_.empty()) topology.nodes_.push_back(std::move(n));
+      }
+#else
+      (void)sysfs_node;
+#endif
+      if(topology.nodes_.empty()) {
+         node n{0, {}};
+         auto count = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+         for(std::size_t cpu = 0; cpu < count; ++cpu) n.cpus_.push_back(cpu);
+         topology.nodes_.push_back(std::move(n));
+      }
+      return topology;
+   }
+
+   // "0-3,8,10-11" -> 0 1 2 3 8 10 11, anything malformed is skipped.
+   static auto parse_cpu_list(std::string_view list) -> std::vector<std::size_t> {
+      std::vector<std::size_t> cpus;
+      while(!list.empty()) {
+         auto comma = list.find(',');
+         auto item = list.substr(0, comma);
+         list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+
+         std::size_t first = 0, last = 0;
+         auto dash = item.find('-');
+         if(!parse_number(item.substr(0, dash), first)) continue;
+         last = first;
+         if(dash != std::string_view::npos && !parse_number(item.substr(dash + 1), last)) continue;
+         for(auto cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+      }
+      return cpus;
+   }
+
+   auto nodes() const noexcept -> const std::vector<node>& {
+      return nodes_;
+   }
+
+   auto cpu_count() const noexcept -> std::size_t {
+      std::size_t count = 0;
+      for(auto& n : nodes_) count += n.cpus_.size();
+      return count;
+   }
+
+private:
+   // empty if it's not there.
+   static auto read_line(std::string const& path) -> std::string {
+      std::string line;
+      std::ifstream file{path};
+      if(file) std::getline(file, line);
+      return line;
+   }
+
+   static auto parse_number(std::string_view s, std::size_t& value) noexcept -> bool {
+      while(!s.empty() && (s.front() == ' ' || s.front() == '\n')) s.remove_prefix(1);
+      while(!s.empty() && (s.back() == ' ' || s.back() == '\n')) s.remove_suffix(1);
+      if(s.empty()) return false;
+      value = 0;
+      for(auto c : s) {
+         if(c < '0' || c > '9') return false;
+         value = value * 10 + static_cast<std::size_t>(c - '0');
+      }
+      return true;
+   }
+
+private:
+   std::vector<node> nodes_;
+};
+
+// bind the calling thread to the given CPUs, false if it can't be done.
+inline auto bind_current_thread(const std::vector<std::size_t>& cpus) noexcept -> bool {
+#if defined(__linux__)
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   for(auto cpu : cpus) {
+      if(cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+   }
+   return CPU_COUNT(&set) > 0 && ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+#else
+   (void)cpus;
+   return false;
+#endif
+}
+
+E_CORO_NS_END
+
+#endif //E_CORO_CPU_TOPOLOGY_H
@@ -0,0 +1,74 @@
+#ifndef E_CORO_WORKER_PARKING_H
+#define E_CORO_WORKER_PARKING_H
+
+#include <e-coro/e_coro_ns.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+E_CORO_NS_BEGIN namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////
+// Where the workers of a pool sleep, while there's no work, and the loop
+// they run. Work is counted by queued() before it's there to be taken, and
+// counted off once it's taken, so no worker goes to sleep past it; notify()
+// wakes one up once it's there. After stop(), the workers quit as soon as
+// nothing's counted, thus all that's scheduled is done.
+/////////////////////////////////////////////////////////////////////////////
+struct worker_parking {
+   auto queued() noexcept -> void {
+      queued_.fetch_add(1, std::memory_order_seq_cst);
+   }
+
+   auto notify() noexcept -> void {
+      if(sleeping_.load(std::memory_order_seq_cst) > 0) {
+         std::lock_guard lock{mutex_};
+         wake_up_.notify_one();
+      }
+   }
+
+   auto stop() noexcept -> void {
+      {
+         std::lock_guard lock{mutex_};
+         stopping_.store(true, std::memory_order_seq_cst);
+      }
+      wake_up_.notify_all();
+   }
+
+   // try_pop() gives a node to resume, nullptr if there's none for now.
+   template<typename TRY_POP>
+   auto run(TRY_POP&& try_pop) noexcept -> void {
+      while(true) {
+         if(auto node = try_pop()) {
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            // the node is gone with its awaiter once it's resumed.
+            node->resume();
+            continue;
+         }
+
+         std::unique_lock lock{mutex_};
+         sleeping_.fetch_add(1, std::memory_order_seq_cst);
+         wake_up_.wait(lock, [this] {
+            return queued_.load(std::memory_order_seq_cst) > 0 ||
+                   stopping_.load(std::memory_order_relaxed);
+         });
+         sleeping_.fetch_sub(1, std::memory_order_relaxed);
+         if(stopping_.load(std::memory_order_relaxed) &&
+            queued_.load(std::memory_order_seq_cst) == 0) {
+            break;
+         }
+      }
+   }
+
+private:
+   std::mutex mutex_;
+   std::condition_variable wake_up_;
+   std::atomic<std::size_t> queued_{0};
+   std::atomic<std::size_t> sleeping_{0};
+   std::atomic<bool> stopping_{false};
+};
+
+} E_CORO_NS_END
+
+#endif //E_CORO_WORKER_PARKING_H
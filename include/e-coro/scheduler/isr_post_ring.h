@@ -0,0 +1,120 @@
+#ifndef E_CORO_ISR_POST_RING_H
+#define E_CORO_ISR_POST_RING_H
+
+#include <e-coro/e_coro_ns.h>
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+
+#if defined(__unix__)
+#include <cerrno>
+#include <semaphore.h>
+// this header's own, #undef'd at its end.
+#define E_CORO_ISR_POST_SEMAPHORE 1
+#else
+#define E_CORO_ISR_POST_SEMAPHORE 0
+#endif
+
+E_CORO_NS_BEGIN
+
+/////////////////////////////////////////////////////////////////////////////
+// A fixed ring an interrupt handler, or a POSIX signal handler, posts ready
+// coroutines into, which are resumed later by a run loop in thread context,
+// instead of right there in the handler.
+//
+// Posting is wait-free: a slot is reserved and claimed by an atomic add
+// each, no CAS loop, no lock and no allocation, thus it's safe even if the
+// handler has interrupted another poster, or the run loop, on the same
+// core. A slot is published once its handle is written; the run loop stops
+// at the first one not published yet, and picks it up in the next round.
+//
+// On POSIX, the run loop sleeps on a semaphore, since sem_post is async-
+// signal-safe; elsewhere it has nothing to sleep on, so drain() is to be
+// called from the idle loop of the board instead of run().
+/////////////////////////////////////////////////////////////////////////////
+template<std::size_t CAPACITY>
+struct isr_post_ring {
+   static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "capacity should be a power of 2");
+   static_assert(std::atomic<std::size_t>::is_always_lock_free);
+   static_assert(std::atomic<void*>::is_always_lock_free);
+
+   isr_post_ring() noexcept {
+#if E_CORO_ISR_POST_SEMAPHORE
+      ::sem_init(&posted_, 0, 0);
+#endif
+   }
+
+   isr_post_ring(isr_post_ring const&) = delete;
+   isr_post_ring& operator=(isr_post_ring const&) = delete;
+
+   ~isr_post_ring() noexcept {
+#if E_CORO_ISR_POST_SEMAPHORE
+      ::sem_destroy(&posted_);
+#endif
+   }
+
+   // false if it's full, the handle is not taken then.
+   auto post_from_isr(std::coroutine_handle<> handle) noexcept -> bool {
+      if(reserved_.fetch_add(1, std::memory_order_acquire) >= CAPACITY) {
+         reserved_.fetch_sub(1, std::memory_order_relaxed);
+         return false;
+      }
+      // with no more than CAPACITY reserved, this slot is consumed already.
+      auto& slot = slots_[tail_.fetch_add(1, std::memory_order_relaxed) & (CAPACITY - 1)];
+      slot.store(handle.address(), std::memory_order_release);
+#if E_CORO_ISR_POST_SEMAPHORE
+      ::sem_post(&posted_);
+#endif
+      return true;
+   }
+
+   // thread context, one at a time; resume all published so far, in order.
+   auto drain() noexcept -> std::size_t {
+      std::size_t n = 0;
+      while(true) {
+         auto& slot = slots_[head_ & (CAPACITY - 1)];
+         auto address = slot.load(std::memory_order_acquire);
+         if(address == nullptr) break;
+         slot.store(nullptr, std::memory_order_relaxed);
+         ++head_;
+         reserved_.fetch_sub(1, std::memory_order_release);
+         std::coroutine_handle<>::from_address(address).resume();
+         ++n;
+      }
+      return n;
+   }
+
+#if E_CORO_ISR_POST_SEMAPHORE
+   // the run loop, till stop() is called.
+   auto run() noexcept -> void {
+      while(!stopping_.load(std::memory_order_acquire)) {
+         drain();
+         while(::sem_wait(&posted_) != 0 && errno == EINTR);
+      }
+      drain();
+   }
+
+   auto stop() noexcept -> void {
+      stopping_.store(true, std::memory_order_release);
+      ::sem_post(&posted_);
+   }
+#endif
+
+private:
+   std::array<std::atomic<void*>, CAPACITY> slots_{};
+   alignas(64) std::atomic<std::size_t> reserved_{0};
+   alignas(64) std::atomic<std::size_t> tail_{0};
+   // the run loop only.
+   alignas(64) std::size_t head_{0};
+   std::atomic<bool> stopping_{false};
+#if E_CORO_ISR_POST_SEMAPHORE
+   sem_t posted_;
+#endif
+};
+
+E_CORO_NS_END
+
+#undef E_CORO_ISR_POST_SEMAPHORE
+
+#endif //E_CORO_ISR_POST_RING_H
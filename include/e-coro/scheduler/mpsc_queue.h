@@ -0,0 +1,63 @@
+#ifndef E_CORO_MPSC_QUEUE_H
+#define E_CORO_MPSC_QUEUE_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/scheduler/schedule_node.h>
+#include <atomic>
+
+E_CORO_NS_BEGIN
+
+/////////////////////////////////////////////////////////////////////////////
+// An intrusive queue of NODEs, linked by their next_, pushed by any thread
+// and popped by one at a time, FIFO; of schedule_nodes, it's a run queue.
+//
+// Producers push onto a lock-free stack with a CAS, which is free of ABA,
+// since nodes are never popped off it one by one: the consumer takes the
+// whole stack at once, and reverses it into a private list to pop from.
+/////////////////////////////////////////////////////////////////////////////
+template<typename NODE>
+struct basic_mpsc_queue {
+   basic_mpsc_queue() noexcept = default;
+   basic_mpsc_queue(basic_mpsc_queue const&) = delete;
+   basic_mpsc_queue& operator=(basic_mpsc_queue const&) = delete;
+
+   auto push(NODE& node) noexcept -> void {
+      auto head = head_.load(std::memory_order_relaxed);
+      do {
+         node.next_ = head;
+      } while(!head_.compare_exchange_weak(head, &node, std::memory_order_release, std::memory_order_relaxed));
+   }
+
+   // the consumer only, nullptr if it's empty.
+   auto pop() noexcept -> NODE* {
+      if(pending_ == nullptr) {
+         auto stack = head_.exchange(nullptr, std::memory_order_acquire);
+         while(stack != nullptr) {
+            auto next = stack->next_;
+            stack->next_ = pending_;
+            pending_ = stack;
+            stack = next;
+         }
+      }
+
+      auto node = pending_;
+      if(node != nullptr) pending_ = node->next_;
+      return node;
+   }
+
+   // the consumer only.
+   auto empty() const noexcept -> bool {
+      return pending_ == nullptr && head_.load(std::memory_order_acquire) == nullptr;
+   }
+
+private:
+   // producers and the consumer don't share a cache line.
+   alignas(64) std::atomic<NODE*> head_{nullptr};
+   alignas(64) NODE* pending_{nullptr};
+};
+
+using mpsc_queue = basic_mpsc_queue<schedule_node>;
+
+E_CORO_NS_END
+
+#endif //E_CORO_MPSC_QUEUE_H
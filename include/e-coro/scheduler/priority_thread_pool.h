@@ -0,0 +1,194 @@
+#ifndef E_CORO_PRIORITY_THREAD_POOL_H
+#define E_CORO_PRIORITY_THREAD_POOL_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/scheduler/schedule_node.h>
+#include <e-coro/scheduler/detail/worker_parking.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+E_CORO_NS_BEGIN
+
+enum class priority : std::uint8_t {
+   high,
+   normal,
+   low
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Like static_thread_pool, but each worker has a queue per priority, and
+// takes the highest one first, in FIFO order. To keep a burst of high ones
+// from starving the rest, a queued one is aged: once it has waited longer
+// than aging * its level (aging for normal, twice for low), it goes before
+// anything of a higher priority.
+//
+// Work from outside the pool is dealt to the workers in turn, thus priority
+// is honoured by the worker it's on; an idle worker steals from others.
+// Queues are intrusive, of the nodes in the awaiters, as in the static one.
+/////////////////////////////////////////////////////////////////////////////
+struct priority_thread_pool {
+   using clock = std::chrono::steady_clock;
+   constexpr static std::size_t levels = 3;
+
+   explicit priority_thread_pool(
+      std::size_t thread_count = default_thread_count(),
+      clock::duration aging = std::chrono::milliseconds{1})
+      : thread_count_{std::max<std::size_t>(thread_count, 1)}
+      , aging_{aging}
+      , workers_{std::make_unique<worker[]>(thread_count_)} {
+      threads_.reserve(thread_count_);
+      for(std::size_t i = 0; i < thread_count_; ++i) {
+         threads_.emplace_back([this, i] { run(i); });
+      }
+   }
+
+   priority_thread_pool(priority_thread_pool const&) = delete;
+   priority_thread_pool& operator=(priority_thread_pool const&) = delete;
+
+   // all scheduled work is done before the workers quit.
+   ~priority_thread_pool() noexcept {
+      parking_.stop();
+      for(auto& thread : threads_) {
+         thread.join();
+      }
+   }
+
+   // a ready coroutine, and since when it's waiting.
+   struct node : schedule_node {
+      clock::time_point since_;
+   };
+
+   struct schedule_operation {
+      auto await_ready() const noexcept { return false; }
+      auto await_suspend(std::coroutine_handle<> self) noexcept {
+         node_.handle_ = self;
+         pool_.post(node_, priority_);
+      }
+      auto await_resume() const noexcept {}
+
+      priority_thread_pool& pool_;
+      priority priority_;
+      node node_{};
+   };
+
+   [[nodiscard("this is an awaitable")]]
+   auto schedule(priority p = priority::normal) noexcept -> schedule_operation {
+      return schedule_operation{*this, p};
+   }
+
+   auto thread_count() const noexcept -> std::size_t {
+      return thread_count_;
+   }
+
+   // the index of the current worker, or thread_count() if it's not mine.
+   auto current_worker_index() const noexcept -> std::size_t {
+      return current_.pool_ == this ? current_.index_ : thread_count_;
+   }
+
+   static auto default_thread_count() noexcept -> std::size_t {
+      return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+   }
+
+private:
+   // FIFO, linked by next_.
+   struct node_queue {
+      auto push(node& n) noexcept -> void {
+         n.next_ = nullptr;
+         if(tail_ == nullptr) head_ = &n;
+         else tail_->next_ = &n;
+         tail_ = &n;
+      }
+
+      auto pop() noexcept -> node* {
+         auto n = head_;
+         head_ = static_cast<node*>(n->next_);
+         if(head_ == nullptr) tail_ = nullptr;
+         return n;
+      }
+
+      node* head_{};
+      node* tail_{};
+   };
+
+   struct alignas(64) worker {
+      std::mutex mutex_;
+      std::array<node_queue, levels> queues_;
+   };
+
+   struct context {
+      const priority_thread_pool* pool_;
+      std::size_t index_;
+   };
+
+   auto post(node& n, priority p) noexcept -> void {
+      auto index = current_worker_index();
+      if(index == thread_count_) {
+         index = next_.fetch_add(1, std::memory_order_relaxed) % thread_count_;
+      }
+      n.since_ = clock::now();
+      parking_.queued();
+      {
+         std::lock_guard lock{workers_[index].mutex_};
+         workers_[index].queues_[static_cast<std::size_t>(p)].push(n);
+      }
+      parking_.notify();
+   }
+
+   auto pop_from(worker& w, clock::time_point now) noexcept -> node* {
+      std::lock_guard lock{w.mutex_};
+      // the lowest one has the longest allowance, it's checked first.
+      for(auto level = levels - 1; level > 0; --level) {
+         auto& queue = w.queues_[level];
+         if(queue.head_ != nullptr && now - queue.head_->since_ >= aging_ * static_cast<int>(level)) {
+            return queue.pop();
+         }
+      }
+      for(auto& queue : w.queues_) {
+         if(queue.head_ != nullptr) return queue.pop();
+      }
+      return nullptr;
+   }
+
+   auto try_pop(std::size_t index) noexcept -> node* {
+      auto now = clock::now();
+      if(auto n = pop_from(workers_[index], now)) {
+         return n;
+      }
+      for(std::size_t i = 1; i < thread_count_; ++i) {
+         if(auto n = pop_from(workers_[(index + i) % thread_count_], now)) {
+            return n;
+         }
+      }
+      return nullptr;
+   }
+
+   auto run(std::size_t index) noexcept -> void {
+      current_ = context{this, index};
+      parking_.run([this, index] { return try_pop(index); });
+      current_ = context{nullptr, 0};
+   }
+
+private:
+   static inline thread_local context current_{nullptr, 0};
+
+   const std::size_t thread_count_;
+   const clock::duration aging_;
+   std::unique_ptr<worker[]> workers_;
+   std::vector<std::thread> threads_;
+   std::atomic<std::size_t> next_{0};
+
+   detail::worker_parking parking_;
+};
+
+E_CORO_NS_END
+
+#endif //E_CORO_PRIORITY_THREAD_POOL_H
@@ -0,0 +1,31 @@
+#ifndef E_CORO_SCHEDULE_NODE_H
+#define E_CORO_SCHEDULE_NODE_H
+
+#include <e-coro/e_coro_ns.h>
+#include <coroutine>
+
+E_CORO_NS_BEGIN
+
+/////////////////////////////////////////////////////////////////////////////
+// A ready coroutine, as an item of an intrusive run queue. It's meant to be
+// a member of the awaiter the coroutine is suspended on, thus it lives in
+// the frame until the coroutine is resumed, and queueing never allocates.
+/////////////////////////////////////////////////////////////////////////////
+struct schedule_node {
+   auto resume() const -> void {
+      handle_.resume();
+   }
+
+   schedule_node* next_{};
+   std::coroutine_handle<> handle_;
+};
+
+// anything a ready coroutine could be handed to, to be resumed later.
+template<typename Q>
+concept schedule_queue_concept = requires(Q& queue, schedule_node& node) {
+   queue.push(node);
+};
+
+E_CORO_NS_END
+
+#endif //E_CORO_SCHEDULE_NODE_H
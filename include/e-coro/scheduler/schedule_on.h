@@ -0,0 +1,170 @@
+#ifndef E_CORO_SCHEDULE_ON_H
+#define E_CORO_SCHEDULE_ON_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/core/awaitable_trait.h>
+#include <e-coro/core/then.h>
+#include <e-coro/core/detail/inline_driver.h>
+#include <e-coro/scheduler/scheduler_concept.h>
+#include <memory>
+#include <optional>
+#include <utility>
+
+E_CORO_NS_BEGIN
+
+namespace detail {
+   template<typename S>
+   using schedule_holder_t = awaiter_holder<decltype(std::declval<S&>().schedule())>;
+
+   // A is a reference to the awaitable, which is started once on s.
+   template<typename S, typename A>
+   struct schedule_on_awaiter {
+      schedule_on_awaiter(S& scheduler, A awaitable)
+         : awaitable_{static_cast<A>(awaitable)}
+         , schedule_{std::in_place, [&] { return scheduler.schedule(); }}
+      {}
+
+      schedule_on_awaiter(schedule_on_awaiter const&) = delete;
+      schedule_on_awaiter& operator=(schedule_on_awaiter const&) = delete;
+
+      ~schedule_on_awaiter() {
+         if(driver_) driver_.destroy();
+      }
+
+      auto await_ready() const noexcept -> bool {
+         return false;
+      }
+
+      auto await_suspend(std::coroutine_handle<> caller) noexcept -> std::coroutine_handle<> {
+         driver_ = drive(frame_, *this).handle_;
+         driver_.promise().context_ = caller.address();
+         driver_.promise().on_done_ = resume_caller;
+         return driver_;
+      }
+
+      auto await_resume() -> decltype(auto) {
+         return awaitable_awaiter_->awaiter().await_resume();
+      }
+
+   private:
+      static auto drive(inline_frame&, schedule_on_awaiter& self) -> inline_driver {
+         co_await awaiter_ref{self.schedule_.awaiter()};
+         self.schedule_.awaiter().await_resume();
+         self.awaitable_awaiter_.emplace(std::in_place, [&self]() -> A {
+            return static_cast<A>(self.awaitable_);
+         });
+         co_await awaiter_ref{self.awaitable_awaiter_->awaiter()};
+      }
+
+   private:
+      A awaitable_;
+      schedule_holder_t<S> schedule_;
+      // got once it's on s.
+      std::optional<awaiter_holder<A>> awaitable_awaiter_;
+      std::coroutine_handle<inline_driver::promise_type> driver_;
+      inline_frame frame_;
+   };
+
+   // A is a reference to the awaitable, which is started right away; the
+   // caller is resumed by s once it's done.
+   template<typename S, typename A>
+   struct resume_on_awaiter {
+      resume_on_awaiter(S& scheduler, A awaitable)
+         : awaitable_awaiter_{std::in_place, [&]() -> A { return static_cast<A>(awaitable); }}
+         , schedule_{std::in_place, [&] { return scheduler.schedule(); }}
+      {}
+
+      resume_on_awaiter(resume_on_awaiter const&) = delete;
+      resume_on_awaiter& operator=(resume_on_awaiter const&) = delete;
+
+      ~resume_on_awaiter() {
+         if(driver_) driver_.destroy();
+      }
+
+      auto await_ready() -> bool {
+         ready_ = awaitable_awaiter_.awaiter().await_ready();
+         return ready_ && schedule_.awaiter().await_ready();
+      }
+
+      auto await_suspend(std::coroutine_handle<> caller) noexcept -> std::coroutine_handle<> {
+         // nothing to wait for but s.
+         if(ready_) {
+            return suspend_to(schedule_.awaiter(), caller);
+         }
+         driver_ = drive(frame_, *this).handle_;
+         driver_.promise().context_ = caller.address();
+         driver_.promise().on_done_ = resume_caller;
+         return driver_;
+      }
+
+      // it's done, and we're on s now, take its result.
+      auto await_resume() -> decltype(auto) {
+         schedule_.awaiter().await_resume();
+         return awaitable_awaiter_.awaiter().await_resume();
+      }
+
+   private:
+      static auto drive(inline_frame&, resume_on_awaiter& self) -> inline_driver {
+         co_await awaiter_ref{self.awaitable_awaiter_.awaiter()};
+         co_await awaiter_ref{self.schedule_.awaiter()};
+      }
+
+   private:
+      awaiter_holder<A> awaitable_awaiter_;
+      schedule_holder_t<S> schedule_;
+      std::coroutine_handle<inline_driver::promise_type> driver_;
+      bool ready_{false};
+      inline_frame frame_;
+   };
+
+   template<template<typename, typename> class AWAITER, typename S, typename A>
+   struct on_scheduler_awaitable final {
+      static_assert(!std::is_reference_v<A>);
+
+      template<constructible_to<A> A_ARG>
+      on_scheduler_awaitable(S& scheduler, A_ARG&& awaitable)
+         : scheduler_{std::addressof(scheduler)}
+         , awaitable_{std::forward<A_ARG>(awaitable)}
+      {}
+
+      auto operator co_await() & {
+         return AWAITER<S, unwrap_t<A&>>{*scheduler_, unwrap(awaitable_)};
+      }
+
+      auto operator co_await() && {
+         return AWAITER<S, unwrap_t<A&&>>{*scheduler_, unwrap(std::move(awaitable_))};
+      }
+
+   private:
+      S* scheduler_;
+      A awaitable_;
+   };
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// co_await schedule_on(s, x): x is started on s, and so is the awaiting
+// coroutine resumed on wherever x completes.
+// co_await resume_on(s, x): x is started right here, the awaiting coroutine
+// is resumed on s once x completes.
+//
+// Both keep x inline, by reference if it's an lvalue. Getting in between
+// the stages takes a small driver coroutine, whose frame is in the awaiter,
+// so neither allocates but for x itself.
+/////////////////////////////////////////////////////////////////////////////
+template<scheduler_concept S, awaitable_concept A>
+[[nodiscard("this is an awaitable")]]
+inline auto schedule_on(S& scheduler, A&& awaitable) {
+   using awaitable_t = detail::on_scheduler_awaitable<detail::schedule_on_awaiter, S, detail::stored_awaitable_t<A>>;
+   return awaitable_t{scheduler, std::forward<A>(awaitable)};
+}
+
+template<scheduler_concept S, awaitable_concept A>
+[[nodiscard("this is an awaitable")]]
+inline auto resume_on(S& scheduler, A&& awaitable) {
+   using awaitable_t = detail::on_scheduler_awaitable<detail::resume_on_awaiter, S, detail::stored_awaitable_t<A>>;
+   return awaitable_t{scheduler, std::forward<A>(awaitable)};
+}
+
+E_CORO_NS_END
+
+#endif //E_CORO_SCHEDULE_ON_H
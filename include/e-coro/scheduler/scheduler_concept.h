@@ -0,0 +1,17 @@
+#ifndef E_CORO_SCHEDULER_CONCEPT_H
+#define E_CORO_SCHEDULER_CONCEPT_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/core/awaitable_trait.h>
+
+E_CORO_NS_BEGIN
+
+// anything that co_await s.schedule() gets the awaiting coroutine resumed on.
+template<typename T>
+concept scheduler_concept = requires(T& scheduler) {
+   { scheduler.schedule() } -> awaitable_concept;
+};
+
+E_CORO_NS_END
+
+#endif //E_CORO_SCHEDULER_CONCEPT_H
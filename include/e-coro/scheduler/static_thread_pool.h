@@ -0,0 +1,240 @@
+#ifndef E_CORO_STATIC_THREAD_POOL_H
+#define E_CORO_STATIC_THREAD_POOL_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/scheduler/cpu_topology.h>
+#include <e-coro/scheduler/mpsc_queue.h>
+#include <e-coro/scheduler/schedule_node.h>
+#include <e-coro/scheduler/detail/worker_parking.h>
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+E_CORO_NS_BEGIN
+
+struct thread_pool_options {
+   // 0 for one per CPU.
+   std::size_t thread_count_ = 0;
+   // bind each worker to a single CPU.
+   bool pin_threads_ = false;
+   // bind each worker to the CPUs of its NUMA node, and steal from the
+   // workers on the same node before the ones across.
+   bool numa_aware_ = false;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// A fixed number of worker threads, each has its own queue. A worker takes
+// its own work LIFO (the latest, which is hot in cache), and steals from
+// others FIFO (the oldest, which is usually the biggest piece of work when
+// it's split recursively). Work from outside the pool goes to a shared one,
+// which is lock-free to push onto. Queues are intrusive, of the nodes in
+// the awaiters, so scheduling never allocates but for a worker's deque.
+//
+// With pinning or NUMA awareness, workers are spread evenly over the allowed
+// CPUs, node by node, so neighbouring workers share a node. A worker binds
+// itself before allocating its own state, thus its queue is first touched,
+// and placed, on its own node.
+/////////////////////////////////////////////////////////////////////////////
+struct static_thread_pool {
+   explicit static_thread_pool(std::size_t thread_count = default_thread_count())
+      : static_thread_pool{thread_pool_options{thread_count}}
+   {}
+
+   explicit static_thread_pool(thread_pool_options const& options)
+      : thread_count_{options.thread_count_ > 0 ? options.thread_count_ : default_thread_count()}
+      , workers_(thread_count_)
+      , started_{static_cast<std::ptrdiff_t>(thread_count_)} {
+      auto placements = place(options);
+      threads_.reserve(thread_count_);
+      for(std::size_t i = 0; i < thread_count_; ++i) {
+         threads_.emplace_back([this, i, &placement = placements[i]] {
+            if(!placement.cpus_.empty()) {
+               bind_current_thread(placement.cpus_);
+            }
+            workers_[i] = std::make_unique<worker>(placement.node_, std::move(placement.steal_order_));
+            // no stealing before all are there.
+            started_.arrive_and_wait();
+            run(i);
+         });
+      }
+      started_.wait();
+   }
+
+   static_thread_pool(static_thread_pool const&) = delete;
+   static_thread_pool& operator=(static_thread_pool const&) = delete;
+
+   // all scheduled work is done before the workers quit.
+   ~static_thread_pool() noexcept {
+      parking_.stop();
+      for(auto& thread : threads_) {
+         thread.join();
+      }
+   }
+
+   struct schedule_operation {
+      auto await_ready() const noexcept { return false; }
+      auto await_suspend(std::coroutine_handle<> self) noexcept {
+         node_.handle_ = self;
+         pool_.push(node_);
+      }
+      auto await_resume() const noexcept {}
+
+      static_thread_pool& pool_;
+      schedule_node node_{};
+   };
+
+   [[nodiscard("this is an awaitable")]]
+   auto schedule() noexcept -> schedule_operation {
+      return schedule_operation{*this};
+   }
+
+   // run a ready coroutine on the pool; node should live until then.
+   auto push(schedule_node& node) noexcept -> void {
+      parking_.queued();
+      if(auto index = current_worker_index(); index < thread_count_) {
+         std::lock_guard lock{workers_[index]->mutex_};
+         workers_[index]->queue_.push_back(&node);
+      } else {
+         global_queue_.push(node);
+      }
+      parking_.notify();
+   }
+
+   auto thread_count() const noexcept -> std::size_t {
+      return thread_count_;
+   }
+
+   // the index of the current worker, or thread_count() if it's not mine.
+   auto current_worker_index() const noexcept -> std::size_t {
+      return current_.pool_ == this ? current_.index_ : thread_count_;
+   }
+
+   // the NUMA node a worker belongs to, 0 unless it's NUMA aware.
+   auto worker_node(std::size_t index) const noexcept -> std::size_t {
+      return workers_[index]->node_;
+   }
+
+   static auto default_thread_count() noexcept -> std::size_t {
+      return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+   }
+
+private:
+   struct alignas(64) worker {
+      worker(std::size_t node, std::vector<std::size_t>&& steal_order)
+         : node_{node}
+         , steal_order_{std::move(steal_order)}
+      {}
+
+      std::mutex mutex_;
+      std::deque<schedule_node*> queue_;
+      const std::size_t node_;
+      // the others, nearest first.
+      const std::vector<std::size_t> steal_order_;
+   };
+
+   struct placement {
+      std::vector<std::size_t> cpus_;
+      std::size_t node_ = 0;
+      std::vector<std::size_t> steal_order_;
+   };
+
+   auto place(thread_pool_options const& options) const -> std::vector<placement> {
+      std::vector<placement> placements(thread_count_);
+      if(options.pin_threads_ || options.numa_aware_) {
+         auto topology = cpu_topology::detect();
+         std::vector<std::pair<std::size_t, const cpu_topology::node*>> cpus;
+         for(auto& n : topology.nodes()) {
+            for(auto cpu : n.cpus_) cpus.emplace_back(cpu, &n);
+         }
+         for(std::size_t i = 0; i < thread_count_; ++i) {
+            auto [cpu, n] = thread_count_ <= cpus.size()
+               ? cpus[i * cpus.size() / thread_count_]
+               : cpus[i % cpus.size()];
+            if(options.pin_threads_) {
+               placements[i].cpus_ = {cpu};
+            } else {
+               placements[i].cpus_ = n->cpus_;
+            }
+            if(options.numa_aware_) {
+               placements[i].node_ = n->id_;
+            }
+         }
+      }
+
+      for(std::size_t i = 0; i < thread_count_; ++i) {
+         auto& order = placements[i].steal_order_;
+         for(std::size_t j = 1; j < thread_count_; ++j) {
+            order.push_back((i + j) % thread_count_);
+         }
+         std::stable_partition(order.begin(), order.end(), [&](auto other) {
+            return placements[other].node_ == placements[i].node_;
+         });
+      }
+      return placements;
+   }
+
+   struct context {
+      const static_thread_pool* pool_;
+      std::size_t index_;
+   };
+
+   auto try_pop(std::size_t index) noexcept -> schedule_node* {
+      {
+         auto& self = *workers_[index];
+         std::lock_guard lock{self.mutex_};
+         if(!self.queue_.empty()) {
+            auto node = self.queue_.back();
+            self.queue_.pop_back();
+            return node;
+         }
+      }
+      // one consumer at a time; if another is at it, there's no waiting,
+      // it's looked at again in the next round.
+      if(!global_consuming_.test_and_set(std::memory_order_acquire)) {
+         auto node = global_queue_.pop();
+         global_consuming_.clear(std::memory_order_release);
+         if(node != nullptr) return node;
+      }
+      for(auto other : workers_[index]->steal_order_) {
+         auto& victim = *workers_[other];
+         std::lock_guard lock{victim.mutex_};
+         if(!victim.queue_.empty()) {
+            auto node = victim.queue_.front();
+            victim.queue_.pop_front();
+            return node;
+         }
+      }
+      return nullptr;
+   }
+
+   auto run(std::size_t index) noexcept -> void {
+      current_ = context{this, index};
+      parking_.run([this, index] { return try_pop(index); });
+      current_ = context{nullptr, 0};
+   }
+
+private:
+   static inline thread_local context current_{nullptr, 0};
+
+   const std::size_t thread_count_;
+   // each is allocated by the worker itself.
+   std::vector<std::unique_ptr<worker>> workers_;
+   std::vector<std::thread> threads_;
+   std::latch started_;
+
+   mpsc_queue global_queue_;
+   std::atomic_flag global_consuming_;
+
+   detail::worker_parking parking_;
+};
+
+E_CORO_NS_END
+
+#endif //E_CORO_STATIC_THREAD_POOL_H
@@ -0,0 +1,69 @@
+#ifndef E_CORO_CHROME_TRACE_H
+#define E_CORO_CHROME_TRACE_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/trace/trace.h>
+#include <cstdint>
+#include <ostream>
+
+#if E_CORO_TRACING
+
+E_CORO_NS_BEGIN
+
+namespace detail {
+   inline auto trace_event_name(trace_event event) noexcept -> const char* {
+      switch(event) {
+         case trace_event::create:   return "create";
+         case trace_event::start:    return "start";
+         case trace_event::suspend:  return "suspend";
+         case trace_event::resume:   return "resume";
+         case trace_event::complete: return "complete";
+         case trace_event::destroy:  return "destroy";
+      }
+      return "unknown";
+   }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Write what's recorded in the Chrome trace event format, which is loaded
+// by chrome://tracing and Perfetto as well. A frame is an async slice from
+// its creation to its destruction, the rest are instants on it.
+//
+// It reads the rings of other threads, so it should be called when nothing
+// is being traced, e.g. after the pools are stopped.
+/////////////////////////////////////////////////////////////////////////////
+inline auto write_chrome_trace(std::ostream& out) -> void {
+   out << "{\"traceEvents\":[";
+   bool first = true;
+   trace::registry::instance().for_each([&](const trace::ring& ring) {
+      ring.for_each([&](const trace_record& record) {
+         const char* phase = "n";
+         const char* name = detail::trace_event_name(record.event_);
+         if(record.event_ == trace_event::create) {
+            phase = "b";
+            name = "coroutine";
+         } else if(record.event_ == trace_event::destroy) {
+            phase = "e";
+            name = "coroutine";
+         }
+
+         out << (first ? "\n" : ",\n");
+         first = false;
+         out << "{\"name\":\"" << name << "\",\"cat\":\"e-coro\",\"ph\":\"" << phase
+             << "\",\"id\":\"" << record.frame_
+             << "\",\"ts\":" << record.time_ns_ / 1000 << '.';
+         auto fraction = record.time_ns_ % 1000;
+         out << static_cast<char>('0' + fraction / 100)
+             << static_cast<char>('0' + fraction / 10 % 10)
+             << static_cast<char>('0' + fraction % 10)
+             << ",\"pid\":1,\"tid\":" << ring.thread() << '}';
+      });
+   });
+   out << "\n]}\n";
+}
+
+E_CORO_NS_END
+
+#endif
+
+#endif //E_CORO_CHROME_TRACE_H
@@ -0,0 +1,227 @@
+#ifndef E_CORO_TRACE_H
+#define E_CORO_TRACE_H
+
+#include <e-coro/e_coro_ns.h>
+#include <e-coro/core/awaitable_trait.h>
+#include <e-coro/core/detail/promise_hooks.h>
+#include <coroutine>
+#include <cstdint>
+#include <utility>
+
+/////////////////////////////////////////////////////////////////////////////
+// Build with E_CORO_TRACING=1 to have the lifecycle of every task, sync_wait
+// and when_all frame recorded: create, start, suspend, resume, complete and
+// destroy. Otherwise the hooks are empty and nothing is left of them.
+//
+// Every translation unit of a program must agree on it, since it changes
+// the layout of the promises.
+/////////////////////////////////////////////////////////////////////////////
+#ifndef E_CORO_TRACING
+#define E_CORO_TRACING 0
+#endif
+
+#if E_CORO_TRACING
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifndef E_CORO_TRACE_RING_CAPACITY
+#define E_CORO_TRACE_RING_CAPACITY 8192
+#endif
+#endif
+
+E_CORO_NS_BEGIN
+
+enum class trace_event : std::uint8_t {
+   create,
+   start,
+   suspend,
+   resume,
+   complete,
+   destroy
+};
+
+struct trace_record {
+   std::uint64_t time_ns_;
+   const void* frame_;
+   trace_event event_;
+};
+
+#if E_CORO_TRACING
+
+namespace trace {
+   /////////////////////////////////////////////////////////////////////////
+   // Each thread records into its own ring, written by that thread only,
+   // thus no lock and no CAS; once full, the oldest are overwritten. Rings
+   // are kept after their threads exit, so they can be exported later.
+   /////////////////////////////////////////////////////////////////////////
+   struct ring {
+      constexpr static std::size_t capacity = E_CORO_TRACE_RING_CAPACITY;
+      static_assert((capacity & (capacity - 1)) == 0, "capacity should be a power of 2");
+
+      explicit ring(std::uint32_t thread) noexcept
+         : thread_{thread}
+      {}
+
+      auto push(trace_event event, const void* frame) noexcept -> void {
+         auto head = head_.load(std::memory_order_relaxed);
+         auto now = std::chrono::steady_clock::now().time_since_epoch();
+         records_[head & (capacity - 1)] = trace_record{
+            static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()),
+            frame, event};
+         head_.store(head + 1, std::memory_order_release);
+      }
+
+      // visit the records kept, oldest first; one slot is kept spare.
+      template<typename F>
+      auto for_each(F&& f) const -> void {
+         auto head = head_.load(std::memory_order_acquire);
+         auto first = head >= capacity ? head - capacity + 1 : 0;
+         for(auto i = first; i < head; ++i) {
+            f(records_[i & (capacity - 1)]);
+         }
+      }
+
+      auto thread() const noexcept -> std::uint32_t {
+         return thread_;
+      }
+
+      auto clear() noexcept -> void {
+         head_.store(0, std::memory_order_release);
+      }
+
+      // take the last one back, if it's still the last one; the slot it's
+      // overwritten is spare, so nothing older shows up again.
+      auto retract(trace_event event, const void* frame) noexcept -> bool {
+         auto head = head_.load(std::memory_order_relaxed);
+         if(head == 0) return false;
+         auto& last = records_[(head - 1) & (capacity - 1)];
+         if(last.event_ != event || last.frame_ != frame) return false;
+         head_.store(head - 1, std::memory_order_release);
+         return true;
+      }
+
+   private:
+      std::array<trace_record, capacity> records_;
+      std::atomic<std::uint64_t> head_{0};
+      const std::uint32_t thread_;
+   };
+
+   struct registry {
+      static auto instance() -> registry& {
+         static registry r;
+         return r;
+      }
+
+      // only once per thread.
+      auto add() -> ring* {
+         std::lock_guard lock{mutex_};
+         auto id = static_cast<std::uint32_t>(rings_.size() + 1);
+         return rings_.emplace_back(std::make_unique<ring>(id)).get();
+      }
+
+      template<typename F>
+      auto for_each(F&& f) -> void {
+         std::lock_guard lock{mutex_};
+         for(auto& r : rings_) f(*r);
+      }
+
+   private:
+      std::mutex mutex_;
+      std::vector<std::unique_ptr<ring>> rings_;
+   };
+
+   inline auto local() noexcept -> ring* {
+      static thread_local ring* mine = registry::instance().add();
+      return mine;
+   }
+
+   inline auto record(trace_event event, const void* frame) noexcept -> void {
+      local()->push(event, frame);
+   }
+
+   // a suspend it turns out there's none of is taken back, unless there's
+   // anything recorded since, then it's a resume right away.
+   inline auto cancel_suspend(const void* frame) noexcept -> void {
+      if(!local()->retract(trace_event::suspend, frame)) {
+         record(trace_event::resume, frame);
+      }
+   }
+
+   // drop all recorded so far, while nothing is being traced.
+   inline auto clear() -> void {
+      registry::instance().for_each([](ring& r) { r.clear(); });
+   }
+}
+
+namespace detail {
+   // a base of the promises being traced, the frame is known by it.
+   struct trace_hooks {
+      trace_hooks() noexcept {
+         trace::record(trace_event::create, this);
+      }
+
+      trace_hooks(trace_hooks const&) = delete;
+      trace_hooks& operator=(trace_hooks const&) = delete;
+
+      ~trace_hooks() noexcept {
+         trace::record(trace_event::destroy, this);
+      }
+
+      template<awaitable_concept A>
+      auto await_transform(A&& awaitable) {
+         return hook_awaiter(*this, std::forward<A>(awaitable));
+      }
+
+      auto trace_initial_suspend() noexcept {
+         return hooked_initial_suspend<trace_hooks>{{}, this};
+      }
+
+      auto on_start() const noexcept -> void {
+         trace::record(trace_event::start, this);
+      }
+
+      auto on_suspend() const noexcept -> void {
+         trace::record(trace_event::suspend, this);
+      }
+
+      auto on_resume() const noexcept -> void {
+         trace::record(trace_event::resume, this);
+      }
+
+      auto on_suspend_cancelled() const noexcept -> void {
+         trace::cancel_suspend(this);
+      }
+
+      auto on_complete() const noexcept -> void {
+         trace::record(trace_event::complete, this);
+      }
+   };
+}
+
+#else
+
+namespace detail {
+   struct trace_hooks {
+      auto trace_initial_suspend() const noexcept {
+         return std::suspend_always{};
+      }
+
+      auto on_start() const noexcept -> void {}
+      auto on_suspend() const noexcept -> void {}
+      auto on_resume() const noexcept -> void {}
+      auto on_suspend_cancelled() const noexcept -> void {}
+      auto on_complete() const noexcept -> void {}
+   };
+
+   static_assert(std::is_empty_v<trace_hooks>);
+}
+
+#endif
+
+E_CORO_NS_END
+
+#endif //E_CORO_TRACE_H
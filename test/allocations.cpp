@@ -0,0 +1,33 @@
+#include "allocations.h"
+#include <cstdlib>
+#include <new>
+
+std::atomic<std::size_t> allocations{0};
+
+namespace {
+   auto counted_alloc(std::size_t size) noexcept -> void* {
+      allocations.fetch_add(1, std::memory_order_relaxed);
+      return std::malloc(size > 0 ? size : 1);
+   }
+}
+
+// all of the unaligned ones, as they're to match the deallocations.
+auto operator new(std::size_t size) -> void* {
+   if(auto p = counted_alloc(size)) return p;
+   std::abort();
+}
+auto operator new[](std::size_t size) -> void* {
+   return operator new(size);
+}
+auto operator new(std::size_t size, std::nothrow_t const&) noexcept -> void* {
+   return counted_alloc(size);
+}
+auto operator new[](std::size_t size, std::nothrow_t const&) noexcept -> void* {
+   return counted_alloc(size);
+}
+auto operator delete(void* p) noexcept -> void { std::free(p); }
+auto operator delete[](void* p) noexcept -> void { std::free(p); }
+auto operator delete(void* p, std::size_t) noexcept -> void { std::free(p); }
+auto operator delete[](void* p, std::size_t) noexcept -> void { std::free(p); }
+auto operator delete(void* p, std::nothrow_t const&) noexcept -> void { std::free(p); }
+auto operator delete[](void* p, std::nothrow_t const&) noexcept -> void { std::free(p); }
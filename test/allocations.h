@@ -0,0 +1,10 @@
+#ifndef E_CORO_ALLOCATIONS_H
+#define E_CORO_ALLOCATIONS_H
+
+#include <atomic>
+#include <cstddef>
+
+// every allocation by operator new, as it's replaced in allocations.cpp.
+extern std::atomic<std::size_t> allocations;
+
+#endif //E_CORO_ALLOCATIONS_H
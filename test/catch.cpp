@@ -2,6 +2,7 @@
 // Created by Darwin Yuan on 2020/7/21.
 //
 #define CATCH_CONFIG_DISABLE_EXCEPTIONS
+#define CATCH_CONFIG_NO_POSIX_SIGNALS
 #define CATCH_CONFIG_MAIN
 //#define CATCH_CONFIG_ENABLE_BENCHMARKING
 #include <catch.hpp>
@@ -0,0 +1,24 @@
+#ifndef E_CORO_RUNNING_REACTOR_H
+#define E_CORO_RUNNING_REACTOR_H
+
+#include <catch.hpp>
+#include <e-coro/io/epoll_reactor.h>
+#include <thread>
+
+// a reactor running on a thread of its own.
+struct running_reactor {
+   running_reactor() {
+      REQUIRE(!reactor_.error());
+      thread_ = std::thread{[this] { reactor_.run(); }};
+   }
+
+   ~running_reactor() {
+      reactor_.stop();
+      thread_.join();
+   }
+
+   e_coro::epoll_reactor reactor_;
+   std::thread thread_;
+};
+
+#endif //E_CORO_RUNNING_REACTOR_H
@@ -0,0 +1,39 @@
+#ifndef E_CORO_TEMP_FILE_H
+#define E_CORO_TEMP_FILE_H
+
+#include <catch.hpp>
+#include <cstdlib>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+
+// a file of the given size, removed along with it.
+struct temp_file {
+   explicit temp_file(std::size_t size) {
+      int fd = ::mkstemp(path_.data());
+      REQUIRE(fd >= 0);
+      content_.resize(size);
+      for(std::size_t i = 0; i < size; ++i) {
+         content_[i] = static_cast<char>(i * 7 + i / 4096);
+      }
+      REQUIRE(::write(fd, content_.data(), size) == static_cast<ssize_t>(size));
+      ::fsync(fd);
+      ::close(fd);
+   }
+
+   ~temp_file() {
+      ::unlink(path_.c_str());
+   }
+
+   // drop it out of the page cache, where the file system lets me.
+   auto evict() const -> void {
+      int fd = ::open(path_.c_str(), O_RDONLY);
+      ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      ::close(fd);
+   }
+
+   std::string path_{"e_coro_file_XXXXXX"};
+   std::string content_;
+};
+
+#endif //E_CORO_TEMP_FILE_H
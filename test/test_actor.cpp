@@ -0,0 +1,138 @@
+#include <catch.hpp>
+#include <e-coro/scheduler/actor.h>
+#include <e-coro/scheduler/mpsc_queue.h>
+#include <e-coro/scheduler/static_thread_pool.h>
+#include <e-coro/core/eager_task.h>
+#include <e-coro/core/task.h>
+#include <e-coro/core/when_all_ready.h>
+#include <e-coro/core/sync_wait_task.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace {
+   using e_coro::task;
+   using e_coro::eager_task;
+   using e_coro::sync_wait;
+   using e_coro::actor;
+   using e_coro::mpsc_queue;
+   using e_coro::static_thread_pool;
+
+   // a run queue drained by hand, the actor's scheduler.
+   using log_actor = actor<std::vector<int>, int, std::size_t, mpsc_queue>;
+
+   auto log_body(log_actor& self, std::vector<int>& log) -> task<> {
+      while(auto request = co_await self.next()) {
+         log.push_back(request->message());
+         request->reply(log.size());
+      }
+   }
+
+   auto ask(log_actor& a, int message, std::size_t& replied) -> eager_task<> {
+      replied = co_await a.ask(message);
+   }
+
+   auto stop(log_actor& a, bool& stopped) -> eager_task<> {
+      co_await a.stop();
+      stopped = true;
+   }
+
+   auto drain(mpsc_queue& queue) -> void {
+      while(auto node = queue.pop()) node->resume();
+   }
+
+   TEST_CASE("actor handles a quantum of messages at a time") {
+      mpsc_queue queue;
+      log_actor a{queue, {}, log_body, 2};
+
+      std::size_t replied[5]{};
+      std::vector<eager_task<>> asking;
+      for(int i = 0; i < 5; ++i) {
+         asking.push_back(ask(a, i * 10, replied[i]));
+      }
+      // all of them are waiting, and the actor is scheduled once.
+      REQUIRE(a.state().empty());
+
+      queue.pop()->resume();
+      // it yields after 2, the ones replied to ahead of it.
+      REQUIRE(a.state().size() == 2);
+
+      drain(queue);
+      REQUIRE(a.state() == std::vector<int>{0, 10, 20, 30, 40});
+      for(std::size_t i = 0; i < 5; ++i) {
+         REQUIRE(asking[i].is_ready());
+         REQUIRE(replied[i] == i + 1);
+      }
+
+      // idle now; the next one gets it scheduled again.
+      std::size_t later = 0;
+      auto asking_later = ask(a, 50, later);
+      drain(queue);
+      REQUIRE(later == 6);
+
+      bool stopped = false;
+      auto stopping = stop(a, stopped);
+      drain(queue);
+      REQUIRE(stopped);
+   }
+
+   TEST_CASE("actor handles messages from many threads one at a time") {
+      static_thread_pool pool{4};
+      std::atomic<int> running{0};
+      std::atomic<bool> overlapped{false};
+
+      actor<int, int, int> counter{pool, 0, [&](auto& self, int& sum) -> task<> {
+         while(auto request = co_await self.next()) {
+            if(running.fetch_add(1) != 0) overlapped = true;
+            sum += request->message();
+            running.fetch_sub(1);
+            request->reply(sum);
+         }
+      }};
+
+      constexpr int asks = 500;
+      auto client = [&]() -> task<int> {
+         co_await pool.schedule();
+         int last = 0;
+         for(int i = 0; i < asks; ++i) {
+            auto sum = co_await counter.ask(1);
+            if(sum <= last) co_return -1;
+            last = sum;
+         }
+         co_return last;
+      };
+
+      auto [a, b, c, d] = sync_wait(e_coro::when_all_ready(client(), client(), client(), client()));
+      // every one saw the sum going up.
+      REQUIRE(a.result() > 0);
+      REQUIRE(b.result() > 0);
+      REQUIRE(c.result() > 0);
+      REQUIRE(d.result() > 0);
+
+      sync_wait([&]() -> task<> {
+         co_await counter.stop();
+      }());
+      REQUIRE(counter.state() == 4 * asks);
+      REQUIRE(!overlapped);
+   }
+
+   TEST_CASE("actor replies with nothing, and is stopped with messages ahead") {
+      static_thread_pool pool{2};
+      std::vector<std::string> handled;
+
+      actor<std::vector<std::string>*, std::string> sink{pool, &handled, [](auto& self, auto& out) -> task<> {
+         while(auto request = co_await self.next()) {
+            out->push_back(std::move(request->message()));
+            request->reply();
+         }
+      }};
+
+      sync_wait([&]() -> task<> {
+         co_await sink.ask("hello");
+         co_await sink.ask("world");
+         co_await sink.stop();
+      }());
+
+      REQUIRE(handled == std::vector<std::string>{"hello", "world"});
+   }
+}
@@ -0,0 +1,96 @@
+#include <catch.hpp>
+#include <e-coro/io/async_file_reader.h>
+#include <e-coro/scheduler/static_thread_pool.h>
+#include <e-coro/core/task.h>
+#include <e-coro/core/sync_wait_task.h>
+#include "temp_file.h"
+#include <string>
+#include <vector>
+
+namespace {
+   using e_coro::task;
+   using e_coro::sync_wait;
+   using e_coro::static_thread_pool;
+   using reader_t = e_coro::async_file_reader<static_thread_pool>;
+
+   auto read_all(reader_t& reader) -> task<std::string> {
+      std::string content;
+      while(true) {
+         auto chunk = co_await reader.next();
+         REQUIRE(chunk.has_value());
+         if(chunk->empty()) break;
+         content.append(reinterpret_cast<const char*>(chunk->data()), chunk->size());
+      }
+      co_return content;
+   }
+
+   TEST_CASE("async_file_reader reads a file in chunks, in order") {
+      static_thread_pool pool{2};
+      temp_file file{4096 * 10 + 123};
+
+      auto reader = reader_t::open(pool, file.path_.c_str(), {.chunk_size_ = 4096, .read_ahead_ = 3});
+      REQUIRE(reader.has_value());
+      REQUIRE(reader->size() == file.content_.size());
+      REQUIRE(sync_wait(read_all(*reader)) == file.content_);
+      // and it stays at the end.
+      REQUIRE(sync_wait(reader->next())->empty());
+   }
+
+   TEST_CASE("async_file_reader reads an empty file") {
+      static_thread_pool pool{1};
+      temp_file file{0};
+
+      auto reader = reader_t::open(pool, file.path_.c_str());
+      REQUIRE(reader.has_value());
+      REQUIRE(sync_wait(read_all(*reader)).empty());
+   }
+
+   TEST_CASE("async_file_reader with direct I/O") {
+      static_thread_pool pool{2};
+      temp_file file{4096 * 5 + 1};
+
+      auto reader = reader_t::open(pool, file.path_.c_str(), {.chunk_size_ = 8192, .read_ahead_ = 2, .direct_ = true});
+      // not every file system supports it.
+      if(!reader.has_value()) {
+         REQUIRE(reader.error() == std::errc::invalid_argument);
+         return;
+      }
+      REQUIRE(sync_wait(read_all(*reader)) == file.content_);
+   }
+
+   TEST_CASE("async_file_reader could be abandoned with reads in flight") {
+      static_thread_pool pool{1};
+      temp_file file{4096 * 8};
+
+      SECTION("closed on the scheduler") {
+         auto reader = reader_t::open(pool, file.path_.c_str(), {.chunk_size_ = 4096, .read_ahead_ = 4});
+         REQUIRE(reader.has_value());
+         sync_wait([&]() -> task<> {
+            co_await pool.schedule();
+            auto chunk = co_await reader->next();
+            REQUIRE(chunk->size() == 4096);
+            co_await reader->close();
+         }());
+      }
+
+      SECTION("destroyed elsewhere") {
+         auto reader = reader_t::open(pool, file.path_.c_str(), {.chunk_size_ = 4096, .read_ahead_ = 4});
+         REQUIRE(reader.has_value());
+      }
+
+      SECTION("destroyed on the only thread of the scheduler, with no reads done yet") {
+         sync_wait([&]() -> task<> {
+            co_await pool.schedule();
+            auto reader = reader_t::open(pool, file.path_.c_str(), {.chunk_size_ = 4096, .read_ahead_ = 4});
+            REQUIRE(reader.has_value());
+         }());
+      }
+   }
+
+   TEST_CASE("async_file_reader fails to open a missing file") {
+      static_thread_pool pool{1};
+      auto reader = reader_t::open(pool, "no/such/file");
+      REQUIRE(!reader.has_value());
+      REQUIRE(reader.error() == std::errc::no_such_file_or_directory);
+   }
+}
@@ -0,0 +1,80 @@
+#include <catch.hpp>
+#include <e-coro/debug/async_stack.h>
+#include <e-coro/core/task.h>
+#include <e-coro/core/sync_wait_task.h>
+#include <e-coro/core/when_all_ready.h>
+#include <e-coro/core/single_consumer_event.h>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#if E_CORO_ASYNC_STACK
+
+namespace {
+   using e_coro::task;
+   using e_coro::sync_wait;
+   using e_coro::single_consumer_event;
+
+   auto leaf(single_consumer_event& event) -> task<int> {
+      co_await event;
+      co_return 1;
+   }
+
+   auto middle(single_consumer_event& event) -> task<int> {
+      co_return co_await leaf(event) + 1;
+   }
+
+   auto root(single_consumer_event& event) -> task<int> {
+      auto value = co_await middle(event);
+      co_return value + 1;
+   }
+
+   auto functions(const e_coro::async_frame* frame) {
+      std::vector<std::string> names;
+      e_coro::for_each_async_frame(frame, [&](const e_coro::async_frame& f) {
+         names.emplace_back(f.function_);
+      });
+      return names;
+   }
+
+   TEST_CASE("async stack of a suspended task") {
+      single_consumer_event event;
+      auto t = root(event);
+
+      sync_wait(e_coro::when_all_ready(
+         [&]() -> task<> {
+            CHECK(co_await t == 3);
+         }(),
+         [&]() -> task<> {
+            // the one awaiting t is a task too.
+            auto names = functions(t.async_frame());
+            REQUIRE(names.size() == 4);
+            CHECK(names[0].find("leaf") != std::string::npos);
+            CHECK(names[1].find("middle") != std::string::npos);
+            CHECK(names[2].find("root") != std::string::npos);
+
+            int fds[2];
+            REQUIRE(::pipe(fds) == 0);
+            e_coro::dump_async_stack(fds[1], t.async_frame());
+            ::close(fds[1]);
+            std::string dumped;
+            char buf[256];
+            for(ssize_t n; (n = ::read(fds[0], buf, sizeof(buf))) > 0;) {
+               dumped.append(buf, static_cast<std::size_t>(n));
+            }
+            ::close(fds[0]);
+
+            CHECK(dumped.rfind("#0 0x", 0) == 0);
+            CHECK(dumped.find("\n#3 0x") != std::string::npos);
+            CHECK(dumped.find("test_async_stack.cpp:19\n") != std::string::npos);
+
+            event.set();
+            co_return;
+         }()));
+
+      // all done, nothing is linked any more.
+      REQUIRE(functions(t.async_frame()).size() == 1);
+   }
+}
+
+#endif
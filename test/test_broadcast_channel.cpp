@@ -0,0 +1,159 @@
+#include <catch.hpp>
+#include <e-coro/core/broadcast_channel.h>
+#include <e-coro/core/task.h>
+#include <e-coro/core/when_all_ready.h>
+#include <e-coro/core/sync_wait_task.h>
+#include <e-coro/scheduler/static_thread_pool.h>
+#include "counted.h"
+#include <vector>
+
+namespace {
+   using e_coro::task;
+   using e_coro::sync_wait;
+   using e_coro::broadcast_channel;
+   using e_coro::broadcast_policy;
+   using e_coro::static_thread_pool;
+
+   using channel = broadcast_channel<int>;
+
+   auto publish_range(channel& ch, int from, int to) -> task<> {
+      for(int i = from; i < to; ++i) {
+         auto published = co_await ch.publish(i);
+         REQUIRE(published);
+      }
+   }
+
+   auto read_all(channel::subscriber& sub) -> task<std::vector<int>> {
+      std::vector<int> values;
+      while(auto value = co_await sub.next()) {
+         values.push_back(*value);
+      }
+      co_return values;
+   }
+
+   TEST_CASE("broadcast_channel drops the oldest for a subscriber lagging behind") {
+      channel ch{4, broadcast_policy::drop_oldest};
+      auto early = ch.subscribe();
+      sync_wait(publish_range(ch, 0, 5));
+      auto late = ch.subscribe();
+      // nobody reads, the publisher goes on anyway.
+      sync_wait(publish_range(ch, 5, 10));
+      ch.close();
+
+      REQUIRE(sync_wait(read_all(early)) == std::vector<int>{6, 7, 8, 9});
+      REQUIRE(early.lagged() == 6);
+      REQUIRE(sync_wait(read_all(late)) == std::vector<int>{6, 7, 8, 9});
+      REQUIRE(late.lagged() == 1);
+   }
+
+   TEST_CASE("broadcast_channel drops the oldest even if a subscriber holds it") {
+      channel ch{4, broadcast_policy::drop_oldest};
+      auto a = ch.subscribe();
+      auto b = ch.subscribe();
+      int published = 0;
+      sync_wait([&]() -> task<> {
+         (void)co_await ch.publish(0);
+         auto x = co_await a.next();
+         auto y = co_await b.next();
+         co_await e_coro::when_all_ready(
+            [&]() -> task<> {
+               for(int i = 1; i < 10; ++i) {
+                  if(co_await ch.publish(i)) ++published;
+               }
+            }(),
+            [&]() -> task<> {
+               // all done by now, nobody's suspended.
+               REQUIRE(published == 9);
+               ch.close();
+               co_return;
+            }());
+         // the slot of 0 is reused twice over, but not the one they hold.
+         REQUIRE(x == y);
+         REQUIRE(*x == 0);
+      }());
+
+      REQUIRE(sync_wait(read_all(a)) == std::vector<int>{6, 7, 8, 9});
+      REQUIRE(a.lagged() == 5);
+      REQUIRE(sync_wait(read_all(b)) == std::vector<int>{6, 7, 8, 9});
+      REQUIRE(b.lagged() == 5);
+   }
+
+   TEST_CASE("broadcast_channel suspends the subscriber till it's published") {
+      channel ch{4};
+      auto sub = ch.subscribe();
+
+      auto [read, published] = sync_wait(e_coro::when_all_ready(read_all(sub), [&]() -> task<> {
+         co_await publish_range(ch, 0, 3);
+         ch.close();
+      }()));
+      (void)published;
+      REQUIRE(read.result() == std::vector<int>{0, 1, 2});
+      REQUIRE(sub.lagged() == 0);
+   }
+
+   TEST_CASE("broadcast_channel holds the publisher back by the slowest subscriber") {
+      static_thread_pool pool{4};
+      channel ch{2, broadcast_policy::backpressure};
+      std::vector<channel::subscriber> subs;
+      for(int i = 0; i < 3; ++i) subs.push_back(ch.subscribe());
+
+      constexpr int total = 2000;
+      auto reader = [&](channel::subscriber& sub) -> task<long> {
+         co_await pool.schedule();
+         long sum = 0;
+         int expected = 0;
+         while(auto value = co_await sub.next().resume_via(pool)) {
+            if(*value != expected++) co_return -1;
+            sum += *value;
+         }
+         co_return sum;
+      };
+      auto publisher = [&]() -> task<> {
+         co_await pool.schedule();
+         for(int i = 0; i < total; ++i) {
+            (void)co_await ch.publish(i).resume_via(pool);
+         }
+         ch.close();
+      };
+
+      auto [a, b, c, p] = sync_wait(e_coro::when_all_ready(reader(subs[0]), reader(subs[1]), reader(subs[2]), publisher()));
+      (void)p;
+      constexpr long sum = long{total} * (total - 1) / 2;
+      REQUIRE(a.result() == sum);
+      REQUIRE(b.result() == sum);
+      REQUIRE(c.result() == sum);
+      for(auto& sub : subs) REQUIRE(sub.lagged() == 0);
+   }
+
+   TEST_CASE("broadcast_channel fails the publisher once it's closed") {
+      channel ch{1, broadcast_policy::backpressure};
+      auto sub = ch.subscribe();
+      auto published = sync_wait([&]() -> task<std::pair<bool, bool>> {
+         auto first = co_await ch.publish(1);
+         ch.close();
+         auto second = co_await ch.publish(2);
+         co_return std::pair{first, second};
+      }());
+      REQUIRE(published == std::pair{true, false});
+      REQUIRE(sync_wait(read_all(sub)) == std::vector<int>{1});
+   }
+
+   TEST_CASE("broadcast_channel stores a value once for every subscriber") {
+      counted::reset_counts();
+      {
+         broadcast_channel<counted> ch{4};
+         auto a = ch.subscribe();
+         auto b = ch.subscribe();
+         sync_wait([&]() -> task<> {
+            (void)co_await ch.publish(counted{});
+            auto x = co_await a.next();
+            auto y = co_await b.next();
+            // the very same one.
+            REQUIRE(x == y);
+            REQUIRE(x->id == 0);
+         }());
+         REQUIRE(counted::copy_construction_count == 0);
+      }
+      REQUIRE(counted::active_count() == 0);
+   }
+}
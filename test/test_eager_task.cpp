@@ -0,0 +1,96 @@
+#include <catch.hpp>
+#include <e-coro/core/eager_task.h>
+#include <e-coro/core/sync_wait_task.h>
+#include <e-coro/core/single_consumer_event.h>
+#include "counted.h"
+#include <thread>
+
+namespace {
+   using e_coro::task;
+   using e_coro::eager_task;
+   using e_coro::sync_wait;
+
+   TEST_CASE("eager_task starts immediately") {
+      bool started = false;
+      auto f = [&]() -> eager_task<int> {
+         started = true;
+         co_return 1;
+      };
+
+      auto t = f();
+      REQUIRE(started);
+      REQUIRE(t.is_ready());
+      REQUIRE(sync_wait(t) == 1);
+   }
+
+   TEST_CASE("awaiting eager_task before it completes") {
+      e_coro::single_consumer_event event;
+      bool reached_after_event = false;
+
+      auto f = [&]() -> eager_task<> {
+         co_await event;
+         reached_after_event = true;
+      };
+
+      auto t = f();
+      REQUIRE(!t.is_ready());
+
+      std::thread setter{[&] {
+         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+         event.set();
+      }};
+
+      sync_wait(t);
+      REQUIRE(reached_after_event);
+      setter.join();
+   }
+
+   TEST_CASE("eager_tasks overlap each other") {
+      e_coro::single_consumer_event e1;
+      e_coro::single_consumer_event e2;
+
+      auto f = [](e_coro::single_consumer_event& event, int value) -> eager_task<int> {
+         co_await event;
+         co_return value;
+      };
+
+      auto a = f(e1, 1);
+      auto b = f(e2, 2);
+
+      // both are waiting at the same time, fire in reverse order.
+      e2.set();
+      REQUIRE(b.is_ready());
+      REQUIRE(!a.is_ready());
+      e1.set();
+
+      REQUIRE(sync_wait([&]() -> task<int> {
+         co_return co_await a + co_await b;
+      }()) == 3);
+   }
+
+   TEST_CASE("make_eager_task starts a lazy task") {
+      bool started = false;
+      auto f = [&]() -> task<int&> {
+         static int value = 3;
+         started = true;
+         co_return value;
+      };
+
+      auto t = e_coro::make_eager_task(f());
+      REQUIRE(started);
+      decltype(auto) result = sync_wait(t);
+      static_assert(std::is_same_v<decltype(result), int&>);
+      REQUIRE(result == 3);
+   }
+
+   TEST_CASE("eager_task destructor destroys result") {
+      counted::reset_counts();
+      {
+         auto t = []() -> eager_task<counted> {
+            co_return counted{};
+         }();
+         REQUIRE(counted::active_count() == 1);
+      }
+      REQUIRE(counted::active_count() == 0);
+   }
+}
@@ -0,0 +1,81 @@
+#include <catch.hpp>
+#include <e-coro/io/eventfd_event.h>
+#include <e-coro/core/task.h>
+#include <e-coro/core/sync_wait_task.h>
+#include "running_reactor.h"
+#include <thread>
+#include <unistd.h>
+
+namespace {
+   using e_coro::task;
+   using e_coro::sync_wait;
+   using e_coro::eventfd_event;
+
+   TEST_CASE("eventfd_event wakes a coroutine on the reactor from another thread") {
+      running_reactor r;
+      auto& reactor = r.reactor_;
+
+      std::thread setter;
+      auto woken_on = sync_wait([&]() -> task<std::thread::id> {
+         co_await reactor.schedule();
+         // made, and destroyed, on the thread of the reactor.
+         auto event = eventfd_event::open(reactor);
+         REQUIRE(event.has_value());
+         setter = std::thread{[&] { event->set(); }};
+         auto waited = co_await *event;
+         setter.join();
+         REQUIRE(waited.has_value());
+         co_return std::this_thread::get_id();
+      }());
+
+      REQUIRE(woken_on == r.thread_.get_id());
+   }
+
+   TEST_CASE("eventfd_event merges the sets before a wait") {
+      running_reactor r;
+      auto& reactor = r.reactor_;
+
+      auto rounds = sync_wait([&]() -> task<int> {
+         co_await reactor.schedule();
+         auto event = eventfd_event::open(reactor, true);
+         event->set();
+         event->set();
+         // it's set already, no suspension.
+         auto waited = co_await *event;
+         REQUIRE(waited.has_value());
+
+         event->set();
+         event->reset();
+         int rounds = 0;
+         for(; rounds < 3; ++rounds) {
+            std::thread{[&] { event->set(); }}.join();
+            waited = co_await *event;
+            REQUIRE(waited.has_value());
+         }
+         co_return rounds;
+      }());
+
+      REQUIRE(rounds == 3);
+   }
+
+   TEST_CASE("eventfd_event tells why a wait failed, rather than it's set") {
+      running_reactor r;
+      auto& reactor = r.reactor_;
+
+      auto error = sync_wait([&]() -> task<std::error_code> {
+         co_await reactor.schedule();
+         auto event = eventfd_event::open(reactor);
+         // the write end of a pipe in its place, which can't be read.
+         int fds[2];
+         REQUIRE(::pipe(fds) == 0);
+         REQUIRE(::dup2(fds[1], event->fd()) == event->fd());
+         ::close(fds[0]);
+         ::close(fds[1]);
+         auto waited = co_await *event;
+         REQUIRE(!waited.has_value());
+         co_return waited.error();
+      }());
+
+      REQUIRE(error == std::errc::bad_file_descriptor);
+   }
+}
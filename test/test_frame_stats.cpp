@@ -0,0 +1,85 @@
+#include <catch.hpp>
+#include <e-coro/debug/frame_stats.h>
+#include <e-coro/core/task.h>
+#include <e-coro/core/sync_wait_task.h>
+#include <e-coro/core/when_all_ready.h>
+#include <e-coro/core/when_all_result.h>
+#include <e-coro/core/result.h>
+#include <array>
+#include <sstream>
+
+#if E_CORO_FRAME_STATS
+
+namespace {
+   using e_coro::task;
+   using e_coro::sync_wait;
+
+   auto stats_of(std::string_view function) -> e_coro::frame_stats {
+      for(auto& s : e_coro::frame_stats_snapshot()) {
+         if(s.name_.find(function) != std::string_view::npos) return s;
+      }
+      return {};
+   }
+
+   // a template has one per instantiation, which other tests may have made.
+   auto all_of(std::string_view function) -> e_coro::frame_stats {
+      e_coro::frame_stats all;
+      for(auto& s : e_coro::frame_stats_snapshot()) {
+         if(s.name_.find(function) == std::string_view::npos) continue;
+         all.allocations_ += s.allocations_;
+         all.live_ += s.live_;
+      }
+      return all;
+   }
+
+   auto small_frame() -> task<int> {
+      co_return 1;
+   }
+
+   auto big_frame() -> task<int> {
+      std::array<char, 1024> buffer{};
+      co_await small_frame();
+      co_return buffer[0];
+   }
+
+   TEST_CASE("a frame is accounted to its coroutine") {
+      auto before = stats_of("big_frame").allocations_;
+      {
+         auto t1 = big_frame();
+         auto t2 = big_frame();
+         auto stats = stats_of("big_frame");
+         REQUIRE(stats.allocations_ == before + 2);
+         REQUIRE(stats.live_ == 2);
+         REQUIRE(stats.peak_live_ >= 2);
+         REQUIRE(stats.frame_size_ > 1024);
+         REQUIRE(stats.total_bytes_ >= 2 * stats.frame_size_);
+      }
+      REQUIRE(stats_of("big_frame").live_ == 0);
+      REQUIRE(stats_of("small_frame").frame_size_ < stats_of("big_frame").frame_size_);
+   }
+
+   auto small_result() -> task<e_coro::result<int, int>> {
+      co_return 1;
+   }
+
+   TEST_CASE("when_all and sync_wait frames are accounted too") {
+      auto before = all_of("make_when_all_task").allocations_;
+      // the children of when_all_ready have no frames of their own.
+      sync_wait(e_coro::when_all_ready(small_frame(), small_frame()));
+      REQUIRE(all_of("make_when_all_task").allocations_ == before);
+
+      REQUIRE(sync_wait(e_coro::when_all_result(small_result(), small_result())).has_value());
+      auto when_all_task = all_of("make_when_all_task");
+      REQUIRE(when_all_task.allocations_ == before + 2);
+      REQUIRE(when_all_task.live_ == 0);
+      auto sync_wait_task = all_of("make_sync_wait_task");
+      REQUIRE(sync_wait_task.allocations_ >= 1);
+      REQUIRE(sync_wait_task.live_ == 0);
+
+      std::ostringstream out;
+      e_coro::write_frame_stats(out);
+      REQUIRE(out.str().find("small_frame") != std::string::npos);
+   }
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include <catch.hpp>
+#include <e-coro/scheduler/isr_post_ring.h>
+#include <e-coro/scheduler/cpu_topology.h>
+#include <e-coro/core/task.h>
+#include <e-coro/core/sync_wait_task.h>
+#include <atomic>
+#include <thread>
+
+#if defined(__linux__)
+#include <csignal>
+#include <pthread.h>
+
+namespace {
+   using e_coro::task;
+   using e_coro::sync_wait;
+
+   e_coro::isr_post_ring<64> ring;
+   std::atomic<void*> interrupted{nullptr};
+   std::atomic<std::size_t> signals{0};
+
+   extern "C" void on_interrupt(int) {
+      signals.fetch_add(1, std::memory_order_relaxed);
+      if(auto address = interrupted.exchange(nullptr)) {
+         ring.post_from_isr(std::coroutine_handle<>::from_address(address));
+      } else {
+         ring.post_from_isr(std::noop_coroutine());
+      }
+   }
+
+   // suspended until the next signal.
+   struct next_interrupt {
+      auto await_ready() const noexcept { return false; }
+      auto await_suspend(std::coroutine_handle<> self) noexcept {
+         interrupted.store(self.address());
+      }
+      auto await_resume() const noexcept {}
+   };
+
+   struct signal_handler {
+      signal_handler() {
+         struct sigaction action{};
+         action.sa_handler = on_interrupt;
+         ::sigemptyset(&action.sa_mask);
+         ::sigaction(SIGUSR1, &action, &old_);
+      }
+      ~signal_handler() {
+         ::sigaction(SIGUSR1, &old_, nullptr);
+      }
+      struct sigaction old_{};
+   };
+
+   TEST_CASE("isr_post_ring is full at its capacity") {
+      e_coro::isr_post_ring<4> small;
+      for(int i = 0; i < 4; ++i) {
+         REQUIRE(small.post_from_isr(std::noop_coroutine()));
+      }
+      REQUIRE(!small.post_from_isr(std::noop_coroutine()));
+      REQUIRE(small.drain() == 4);
+      REQUIRE(small.drain() == 0);
+      REQUIRE(small.post_from_isr(std::noop_coroutine()));
+      REQUIRE(small.drain() == 1);
+   }
+
+   TEST_CASE("a coroutine woken by a signal is resumed by the run loop") {
+      signal_handler handler;
+      std::thread::id drained_on;
+      std::thread drainer{[&] {
+         e_coro::bind_current_thread({0});
+         drained_on = std::this_thread::get_id();
+         ring.run();
+      }};
+
+      std::thread interrupter{[] {
+         while(interrupted.load() == nullptr) std::this_thread::yield();
+         ::pthread_kill(::pthread_self(), SIGUSR1);
+      }};
+
+      auto resumed_on = sync_wait([]() -> task<std::thread::id> {
+         co_await next_interrupt{};
+         co_return std::this_thread::get_id();
+      }());
+
+      interrupter.join();
+      ring.stop();
+      drainer.join();
+
+      REQUIRE(resumed_on == drained_on);
+      REQUIRE(resumed_on != std::this_thread::get_id());
+   }
+
+   TEST_CASE("signals keep posting while the ring is drained") {
+      signal_handler handler;
+
+      std::atomic<bool> stop{false};
+      std::size_t drained = 0;
+      std::thread drainer{[&] {
+         while(!stop.load()) drained += ring.drain();
+         drained += ring.drain();
+      }};
+
+      auto before = signals.load();
+      std::thread interrupter{[] {
+         for(int i = 0; i < 1000; ++i) {
+            ::pthread_kill(::pthread_self(), SIGUSR1);
+         }
+      }};
+      interrupter.join();
+      stop.store(true);
+      drainer.join();
+
+      // a signal finding the ring full is dropped.
+      REQUIRE(signals.load() - before == 1000);
+      REQUIRE(drained > 0);
+      REQUIRE(drained <= 1000);
+   }
+}
+
+#endif
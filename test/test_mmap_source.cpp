@@ -0,0 +1,98 @@
+#include <catch.hpp>
+#include <e-coro/io/mmap_source.h>
+#include <e-coro/scheduler/mpsc_queue.h>
+#include <e-coro/core/task.h>
+#include <e-coro/core/eager_task.h>
+#include <e-coro/core/sync_wait_task.h>
+#include "temp_file.h"
+#include <string>
+#include <thread>
+#include <sys/mman.h>
+
+namespace {
+   using e_coro::task;
+   using e_coro::sync_wait;
+   using e_coro::mmap_source;
+
+   TEST_CASE("mmap_source maps a file") {
+      temp_file file{3 * 4096 + 5};
+      auto source = mmap_source::open(file.path_.c_str());
+      REQUIRE(source.has_value());
+      REQUIRE(source->size() == 3 * 4096 + 5);
+      REQUIRE(static_cast<char>(source->bytes().back()) == file.content_.back());
+   }
+
+   TEST_CASE("mmap_source prefetch resumes once the range is resident") {
+      temp_file file{64 * 4096};
+      auto source = mmap_source::open(file.path_.c_str());
+      REQUIRE(source.has_value());
+      file.evict();
+
+      sync_wait([&]() -> task<> {
+         co_await source->prefetch(4096, 32 * 4096);
+      }());
+      REQUIRE(source->is_resident(4096, 32 * 4096));
+
+      // out of range is clamped.
+      REQUIRE(source->prefetch(64 * 4096, 100).await_ready());
+   }
+
+   TEST_CASE("mmap_source prefetch resumes via a run queue") {
+      temp_file file{16 * 4096};
+      auto source = mmap_source::open(file.path_.c_str());
+      REQUIRE(source.has_value());
+      file.evict();
+
+      e_coro::mpsc_queue queue;
+      auto main_id = std::this_thread::get_id();
+      auto prefetching = e_coro::make_eager_task([&]() -> task<std::thread::id> {
+         co_await source->prefetch(0, 16 * 4096).resume_via(queue);
+         co_return std::this_thread::get_id();
+      }());
+
+      // nobody else resumes it, but me draining the queue.
+      while(!prefetching.is_ready()) {
+         if(auto node = queue.pop()) node->resume();
+         else std::this_thread::yield();
+      }
+      REQUIRE(sync_wait(prefetching) == main_id);
+      REQUIRE(source->is_resident(0, 16 * 4096));
+   }
+
+   TEST_CASE("the pages of a range are told resident or not, window by window") {
+      auto page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+      constexpr std::size_t n = 1000;
+      auto p = static_cast<std::byte*>(::mmap(nullptr, n * page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+      REQUIRE(p != MAP_FAILED);
+      for(std::size_t i = 0; i < n; i += 2) p[i * page_size] = std::byte{1};
+
+      std::size_t visited = 0, resident = 0;
+      bool in_order = true;
+      e_coro::detail::for_each_page(p, p + n * page_size, page_size, [&](std::uintptr_t page, bool r) {
+         in_order = in_order && page == reinterpret_cast<std::uintptr_t>(p) + visited * page_size;
+         ++visited;
+         resident += r;
+         return true;
+      });
+      REQUIRE(in_order);
+      REQUIRE(visited == n);
+      REQUIRE(resident == n / 2);
+      REQUIRE(e_coro::detail::is_resident(p, p + 1, page_size));
+      REQUIRE(!e_coro::detail::is_resident(p, p + n * page_size, page_size));
+      ::munmap(p, n * page_size);
+   }
+
+   TEST_CASE("mmap_source of an empty file") {
+      temp_file file{0};
+      auto source = mmap_source::open(file.path_.c_str());
+      REQUIRE(source.has_value());
+      REQUIRE(source->bytes().empty());
+      REQUIRE(source->is_resident(0, 100));
+   }
+
+   TEST_CASE("mmap_source fails to open a missing file") {
+      auto source = mmap_source::open("no/such/file");
+      REQUIRE(!source.has_value());
+      REQUIRE(source.error() == std::errc::no_such_file_or_directory);
+   }
+}
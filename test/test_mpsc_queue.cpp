@@ -0,0 +1,139 @@
+#include <catch.hpp>
+#include <e-coro/scheduler/mpsc_queue.h>
+#include <e-coro/scheduler/static_thread_pool.h>
+#include <e-coro/core/task.h>
+#include <e-coro/core/sync_wait_task.h>
+#include <e-coro/core/when_all_ready.h>
+#include <e-coro/core/single_consumer_event.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+   using e_coro::task;
+   using e_coro::sync_wait;
+   using e_coro::when_all_ready;
+   using e_coro::mpsc_queue;
+   using e_coro::schedule_node;
+   using e_coro::single_consumer_event;
+
+   static_assert(e_coro::schedule_queue_concept<mpsc_queue>);
+   static_assert(e_coro::schedule_queue_concept<e_coro::static_thread_pool>);
+
+   TEST_CASE("mpsc_queue is FIFO") {
+      mpsc_queue queue;
+      schedule_node nodes[3];
+      REQUIRE(queue.empty());
+
+      queue.push(nodes[0]);
+      queue.push(nodes[1]);
+      REQUIRE(queue.pop() == &nodes[0]);
+      queue.push(nodes[2]);
+      REQUIRE(!queue.empty());
+      REQUIRE(queue.pop() == &nodes[1]);
+      REQUIRE(queue.pop() == &nodes[2]);
+      REQUIRE(queue.pop() == nullptr);
+      REQUIRE(queue.empty());
+   }
+
+   TEST_CASE("mpsc_queue keeps the order of each producer") {
+      constexpr std::size_t producers = 4;
+      constexpr std::size_t per_producer = 10'000;
+      mpsc_queue queue;
+      std::vector<schedule_node> nodes(producers * per_producer);
+
+      std::vector<std::thread> threads;
+      for(std::size_t p = 0; p < producers; ++p) {
+         threads.emplace_back([&, p] {
+            for(std::size_t i = 0; i < per_producer; ++i) {
+               queue.push(nodes[p * per_producer + i]);
+            }
+         });
+      }
+
+      std::vector<std::size_t> next(producers, 0);
+      std::size_t popped = 0;
+      bool in_order = true;
+      while(popped < nodes.size()) {
+         if(auto node = queue.pop()) {
+            auto index = static_cast<std::size_t>(node - nodes.data());
+            auto p = index / per_producer;
+            in_order = in_order && index % per_producer == next[p];
+            ++next[p];
+            ++popped;
+         }
+      }
+      for(auto& thread : threads) thread.join();
+
+      REQUIRE(in_order);
+      REQUIRE(queue.pop() == nullptr);
+   }
+
+   TEST_CASE("single_consumer_event hands the consumer over to a queue") {
+      mpsc_queue queue;
+      single_consumer_event event;
+      bool resumed = false;
+
+      auto consumer = [&]() -> task<> {
+         co_await event;
+         resumed = true;
+      };
+
+      auto producer = [&]() -> task<> {
+         event.set(queue);
+         REQUIRE(!resumed);
+         auto node = queue.pop();
+         REQUIRE(node != nullptr);
+         node->resume();
+         REQUIRE(resumed);
+         REQUIRE(queue.pop() == nullptr);
+         co_return;
+      };
+
+      sync_wait(when_all_ready(consumer(), producer()));
+   }
+
+   TEST_CASE("when_all_ready resumes the awaiting one via a queue") {
+      mpsc_queue queue;
+      single_consumer_event event;
+      bool done = false;
+
+      auto waiting = [&]() -> task<> {
+         co_await event;
+      };
+
+      auto outer = [&]() -> task<> {
+         co_await when_all_ready(waiting(), []() -> task<> { co_return; }()).resume_via(queue);
+         done = true;
+      };
+
+      auto driver = [&]() -> task<> {
+         // the child completes the last here, but i go on.
+         event.set();
+         REQUIRE(!done);
+         queue.pop()->resume();
+         REQUIRE(done);
+         co_return;
+      };
+
+      sync_wait(when_all_ready(outer(), driver()));
+   }
+
+   TEST_CASE("a pool is a queue to hand a ready coroutine over to") {
+      e_coro::static_thread_pool pool{1};
+      single_consumer_event event;
+      std::thread::id resumed_on;
+
+      auto consumer = [&]() -> task<> {
+         co_await event;
+         resumed_on = std::this_thread::get_id();
+      };
+
+      sync_wait(when_all_ready(consumer(), [&]() -> task<> {
+         event.set(pool);
+         co_return;
+      }()));
+
+      REQUIRE(resumed_on != std::this_thread::get_id());
+   }
+}
@@ -0,0 +1,157 @@
+#include <catch.hpp>
+#include <e-coro/scheduler/static_thread_pool.h>
+#include <e-coro/scheduler/cpu_topology.h>
+#include <e-coro/algorithm/parallel.h>
+#include <e-coro/core/task.h>
+#include <e-coro/core/sync_wait_task.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <ranges>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+   using e_coro::task;
+   using e_coro::sync_wait;
+   using e_coro::static_thread_pool;
+
+   TEST_CASE("static_thread_pool resumes on a worker") {
+      static_thread_pool pool{2};
+      auto main_id = std::this_thread::get_id();
+
+      auto on_worker = sync_wait([&]() -> task<bool> {
+         co_await pool.schedule();
+         co_return std::this_thread::get_id() != main_id &&
+                   pool.current_worker_index() < pool.thread_count();
+      }());
+
+      REQUIRE(on_worker);
+      REQUIRE(pool.current_worker_index() == pool.thread_count());
+   }
+
+   TEST_CASE("cpu list of a NUMA node") {
+      using e_coro::cpu_topology;
+      REQUIRE(cpu_topology::parse_cpu_list("0-3,8,10-11\n") == std::vector<std::size_t>{0, 1, 2, 3, 8, 10, 11});
+      REQUIRE(cpu_topology::parse_cpu_list("5") == std::vector<std::size_t>{5});
+      REQUIRE(cpu_topology::parse_cpu_list("").empty());
+      REQUIRE(cpu_topology::parse_cpu_list("x,2").size() == 1);
+
+      auto topology = cpu_topology::detect();
+      REQUIRE(!topology.nodes().empty());
+      REQUIRE(topology.cpu_count() > 0);
+   }
+
+#if defined(__linux__)
+   TEST_CASE("cpu_topology takes the nodes online, with gaps in between") {
+      namespace fs = std::filesystem;
+      auto root = fs::temp_directory_path() / ("e_coro_nodes_" + std::to_string(::getpid()));
+      fs::create_directories(root / "node0");
+      fs::create_directories(root / "node2");
+      std::ofstream{root / "online"} << "0,2\n";
+      // whichever CPUs are allowed here.
+      std::ofstream{root / "node0" / "cpulist"} << "0-1023\n";
+      std::ofstream{root / "node2" / "cpulist"} << "0-1023\n";
+
+      auto topology = e_coro::cpu_topology::detect(root.string());
+      fs::remove_all(root);
+
+      REQUIRE(topology.nodes().size() == 2);
+      REQUIRE(topology.nodes()[0].id_ == 0);
+      REQUIRE(topology.nodes()[1].id_ == 2);
+   }
+#endif
+
+   TEST_CASE("pinned static_thread_pool") {
+      auto pinned = e_coro::thread_pool_options{4, true, true};
+      static_thread_pool pool{pinned};
+      REQUIRE(pool.thread_count() == 4);
+
+      auto topology = e_coro::cpu_topology::detect();
+      for(std::size_t i = 0; i < pool.thread_count(); ++i) {
+         auto node = pool.worker_node(i);
+         REQUIRE(std::any_of(topology.nodes().begin(), topology.nodes().end(), [=](auto& n) {
+            return n.id_ == node;
+         }));
+      }
+
+      std::vector<std::atomic<int>> visits(10'000);
+      sync_wait([&]() -> task<> {
+         co_await e_coro::parallel_for(pool, visits, 16, [](std::atomic<int>& v) {
+            v.fetch_add(1, std::memory_order_relaxed);
+         });
+      }());
+      REQUIRE(std::all_of(visits.begin(), visits.end(), [](auto& v) { return v.load() == 1; }));
+
+#if defined(__linux__)
+      // a cpuset could keep a thread from being narrowed down to one CPU.
+      bool can_pin = false;
+      std::thread{[&] {
+         cpu_set_t set;
+         CPU_ZERO(&set);
+         can_pin = e_coro::bind_current_thread({topology.nodes().front().cpus_.front()}) &&
+                   ::sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) == 1;
+      }}.join();
+      if(!can_pin) {
+         WARN("threads can't be pinned here, skipped");
+         return;
+      }
+
+      auto cpus_on_worker = sync_wait([&]() -> task<int> {
+         co_await pool.schedule();
+         cpu_set_t set;
+         CPU_ZERO(&set);
+         ::sched_getaffinity(0, sizeof(set), &set);
+         co_return CPU_COUNT(&set);
+      }());
+      REQUIRE(cpus_on_worker == 1);
+#endif
+   }
+
+   TEST_CASE("parallel_for visits each element exactly once") {
+      static_thread_pool pool{4};
+      std::vector<std::atomic<int>> visits(100'000);
+
+      sync_wait([&]() -> task<> {
+         co_await e_coro::parallel_for(pool, visits, 64, [](std::atomic<int>& v) {
+            v.fetch_add(1, std::memory_order_relaxed);
+         });
+      }());
+
+      REQUIRE(std::all_of(visits.begin(), visits.end(), [](auto& v) { return v.load() == 1; }));
+   }
+
+   TEST_CASE("parallel_for over an empty range") {
+      static_thread_pool pool{2};
+      std::vector<int> empty;
+      sync_wait([&]() -> task<> {
+         co_await e_coro::parallel_for(pool, empty, 1, [](int&) {});
+      }());
+   }
+
+   TEST_CASE("parallel_reduce folds the range") {
+      static_thread_pool pool{4};
+
+      auto sum = sync_wait([&]() -> task<long> {
+         co_return co_await e_coro::parallel_reduce(
+            pool, std::views::iota(1L, 1'000'001L), 10L, std::plus<>{});
+      }());
+
+      REQUIRE(sum == 10L + 1'000'000L * 1'000'001L / 2);
+   }
+
+   TEST_CASE("parallel_reduce with a single worker and a coarse grain") {
+      static_thread_pool pool{1};
+      std::vector<int> values(1000);
+      std::iota(values.begin(), values.end(), 0);
+
+      auto max = sync_wait([&]() -> task<int> {
+         co_return co_await e_coro::parallel_reduce(
+            pool, values, -1, [](int a, int b) { return std::max(a, b); }, 300);
+      }());
+
+      REQUIRE(max == 999);
+   }
+}
@@ -0,0 +1,89 @@
+#include <catch.hpp>
+#include <e-coro/io/pipe.h>
+#include <e-coro/core/task.h>
+#include <e-coro/core/when_all_ready.h>
+#include <e-coro/core/sync_wait_task.h>
+#include "running_reactor.h"
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+   using e_coro::task;
+   using e_coro::sync_wait;
+   using e_coro::pipe_reader;
+   using e_coro::pipe_writer;
+
+   auto read_all(pipe_reader& reader) -> task<std::string> {
+      std::string content;
+      std::vector<std::byte> buffer(16 * 1024);
+      while(true) {
+         auto n = co_await reader.read(buffer);
+         REQUIRE(n.has_value());
+         if(*n == 0) break;
+         content.append(reinterpret_cast<const char*>(buffer.data()), *n);
+      }
+      co_return content;
+   }
+
+   TEST_CASE("pipe writes more than it buffers, and reads it all") {
+      running_reactor r;
+      auto& reactor = r.reactor_;
+
+      std::string payload(1024 * 1024, '\0');
+      for(std::size_t i = 0; i < payload.size(); ++i) {
+         payload[i] = static_cast<char>('A' + i % 26);
+      }
+
+      auto received = sync_wait([&]() -> task<std::string> {
+         co_await reactor.schedule();
+         auto pipe = e_coro::open_pipe(reactor);
+         REQUIRE(pipe.has_value());
+         auto& [reader, writer] = *pipe;
+
+         auto writing = [&]() -> task<> {
+            auto written = co_await writer.write(std::as_bytes(std::span{payload.data(), payload.size()}));
+            REQUIRE(written.has_value());
+            REQUIRE(*written == payload.size());
+            // the end of stream.
+            writer = pipe_writer{};
+         };
+
+         auto [content, done] = co_await e_coro::when_all_ready(read_all(reader), writing());
+         (void)done;
+         co_return std::move(content).result();
+      }());
+
+      REQUIRE(received == payload);
+   }
+
+   TEST_CASE("pipe reads the output of a subprocess") {
+      running_reactor r;
+      auto& reactor = r.reactor_;
+
+      int fds[2];
+      REQUIRE(::pipe(fds) == 0);
+      auto child = ::fork();
+      REQUIRE(child >= 0);
+      if(child == 0) {
+         ::close(fds[0]);
+         const char message[] = "hello from the child";
+         (void)!::write(fds[1], message, sizeof(message) - 1);
+         ::_exit(0);
+      }
+      ::close(fds[1]);
+
+      auto output = sync_wait([&]() -> task<std::string> {
+         co_await reactor.schedule();
+         auto reader = pipe_reader::adopt(reactor, fds[0]);
+         REQUIRE(reader.has_value());
+         co_return co_await read_all(*reader);
+      }());
+
+      int status = 0;
+      ::waitpid(child, &status, 0);
+      REQUIRE(output == "hello from the child");
+   }
+}
@@ -0,0 +1,96 @@
+#include <catch.hpp>
+#include <e-coro/scheduler/priority_thread_pool.h>
+#include <e-coro/scheduler/scheduler_concept.h>
+#include <e-coro/algorithm/parallel.h>
+#include <e-coro/core/task.h>
+#include <e-coro/core/sync_wait_task.h>
+#include <e-coro/core/when_all_ready.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+   using e_coro::task;
+   using e_coro::sync_wait;
+   using e_coro::priority;
+   using e_coro::priority_thread_pool;
+
+   static_assert(e_coro::worker_pool_concept<priority_thread_pool>);
+
+   struct recorder {
+      auto add(std::string name) {
+         std::lock_guard lock{mutex_};
+         order_.push_back(std::move(name));
+      }
+      std::mutex mutex_;
+      std::vector<std::string> order_;
+   };
+
+   auto run_at(priority_thread_pool& pool, priority p, recorder& r, std::string name) -> task<> {
+      co_await pool.schedule(p);
+      r.add(std::move(name));
+   }
+
+   TEST_CASE("priority_thread_pool takes the highest priority first") {
+      priority_thread_pool pool{1, std::chrono::hours{1}};
+      std::atomic<bool> released{false};
+      recorder r;
+
+      // keep the only worker busy, until all are queued.
+      auto blocker = [&]() -> task<> {
+         co_await pool.schedule(priority::high);
+         while(!released.load()) std::this_thread::yield();
+      };
+
+      sync_wait(e_coro::when_all_ready(
+         blocker(),
+         run_at(pool, priority::low, r, "low"),
+         run_at(pool, priority::normal, r, "normal 1"),
+         run_at(pool, priority::high, r, "high"),
+         run_at(pool, priority::normal, r, "normal 2"),
+         [&]() -> task<> {
+            released = true;
+            co_return;
+         }()));
+
+      REQUIRE(r.order_ == std::vector<std::string>{"high", "normal 1", "normal 2", "low"});
+   }
+
+   TEST_CASE("priority_thread_pool ages the waiting ones") {
+      priority_thread_pool pool{1, std::chrono::microseconds{100}};
+      std::atomic<bool> released{false};
+      recorder r;
+
+      auto blocker = [&]() -> task<> {
+         co_await pool.schedule(priority::high);
+         while(!released.load()) std::this_thread::yield();
+         std::this_thread::sleep_for(std::chrono::milliseconds{5});
+         // a fresh high one doesn't go before a low one which waited long enough.
+         co_await pool.schedule(priority::high);
+         r.add("high");
+      };
+
+      sync_wait(e_coro::when_all_ready(
+         blocker(),
+         run_at(pool, priority::low, r, "low"),
+         [&]() -> task<> {
+            released = true;
+            co_return;
+         }()));
+
+      REQUIRE(r.order_ == std::vector<std::string>{"low", "high"});
+   }
+
+   TEST_CASE("parallel_for on priority_thread_pool") {
+      priority_thread_pool pool{3};
+      std::vector<std::atomic<int>> visits(10'000);
+      sync_wait([&]() -> task<> {
+         co_await e_coro::parallel_for(pool, visits, 32, [](std::atomic<int>& v) {
+            v.fetch_add(1, std::memory_order_relaxed);
+         });
+      }());
+      REQUIRE(std::all_of(visits.begin(), visits.end(), [](auto& v) { return v.load() == 1; }));
+   }
+}
@@ -0,0 +1,155 @@
+#include <catch.hpp>
+#include <e-coro/core/task.h>
+#include <e-coro/core/try_await.h>
+#include <e-coro/core/when_all_result.h>
+#include <e-coro/core/when_all_ready.h>
+#include <e-coro/core/sync_wait_task.h>
+#include <e-coro/core/single_consumer_event.h>
+#include <e-coro/core/fmap.h>
+#include "counted.h"
+#include <string>
+
+namespace {
+   using e_coro::task;
+   using e_coro::result;
+   using e_coro::unexpected;
+   using e_coro::try_await;
+   using e_coro::sync_wait;
+
+   enum class errc { not_found = 1, timeout };
+
+   auto lookup(int key) -> task<result<int, errc>> {
+      if(key < 0) co_return unexpected{errc::not_found};
+      co_return key * 10;
+   }
+
+   TEST_CASE("result keeps either a value or an error") {
+      result<std::string, errc> ok = std::string{"abc"};
+      REQUIRE(ok.has_value());
+      REQUIRE(ok->size() == 3);
+
+      result<std::string, errc> ko = unexpected{errc::timeout};
+      REQUIRE(!ko);
+      REQUIRE(ko.error() == errc::timeout);
+
+      ok = ko;
+      REQUIRE(ok.error() == errc::timeout);
+
+      result<void, errc> done;
+      REQUIRE(done.has_value());
+   }
+
+   TEST_CASE("try_await gives the value on success") {
+      auto f = []() -> task<result<int, errc>> {
+         auto a = co_await try_await(lookup(1));
+         auto b = co_await try_await(result<int, errc>{2});
+         co_return a + b;
+      };
+
+      auto r = sync_wait(f());
+      REQUIRE(r.has_value());
+      REQUIRE(*r == 12);
+   }
+
+   TEST_CASE("try_await short-circuits the rest of the body") {
+      counted::reset_counts();
+      bool reached = false;
+
+      auto f = [&]() -> task<result<int, errc>> {
+         counted c;
+         auto a = co_await try_await(lookup(-1));
+         reached = true;
+         co_return a;
+      };
+
+      {
+         auto t = f();
+         auto& r = sync_wait(t);
+         REQUIRE(!reached);
+         REQUIRE(!r.has_value());
+         REQUIRE(r.error() == errc::not_found);
+         REQUIRE(t.is_ready());
+         // the body is left suspended, its locals are still alive.
+         REQUIRE(counted::active_count() == 1);
+      }
+
+      REQUIRE(counted::active_count() == 0);
+   }
+
+   TEST_CASE("error propagates through nested try_await after async completion") {
+      e_coro::single_consumer_event event;
+      int steps = 0;
+
+      auto leaf = [&]() -> task<result<void, errc>> {
+         co_await event;
+         co_return unexpected{errc::timeout};
+      };
+
+      auto middle = [&]() -> task<result<std::string, errc>> {
+         co_await try_await(leaf());
+         ++steps;
+         co_return std::string{"unreachable"};
+      };
+
+      auto top = [&]() -> task<result<int, errc>> {
+         auto s = co_await try_await(middle());
+         ++steps;
+         co_return static_cast<int>(s.size());
+      };
+
+      std::optional<result<int, errc>> r;
+      sync_wait(e_coro::when_all_ready(
+         [&]() -> task<> {
+            r.emplace(co_await top());
+         }(),
+         [&]() -> task<> {
+            event.set();
+            co_return;
+         }()));
+
+      REQUIRE(steps == 0);
+      REQUIRE(r.has_value());
+      REQUIRE(!r->has_value());
+      REQUIRE(r->error() == errc::timeout);
+   }
+
+   TEST_CASE("try_await on other awaitables of result") {
+      using e_coro::fmap;
+      auto f = []() -> task<result<int, errc>> {
+         co_return co_await try_await(lookup(2) | fmap([](auto r) { return r; }));
+      };
+      REQUIRE(*sync_wait(f()) == 20);
+   }
+
+   TEST_CASE("when_all_ready collects non-void results") {
+      auto [a, b] = sync_wait(e_coro::when_all_ready(lookup(1), lookup(2)));
+      REQUIRE(*a.result() == 10);
+      REQUIRE(*b.result() == 20);
+   }
+
+   TEST_CASE("when_all_result joins values") {
+      auto r = sync_wait(e_coro::when_all_result(
+         lookup(1),
+         []() -> task<result<void, errc>> { co_return result<void, errc>{}; }(),
+         []() -> task<result<std::string, errc>> { co_return std::string{"x"}; }()));
+
+      REQUIRE(r.has_value());
+      REQUIRE(std::get<0>(*r) == 10);
+      REQUIRE(std::get<2>(*r) == "x");
+   }
+
+   TEST_CASE("when_all_result stops starting children on first error") {
+      bool started = false;
+      auto r = sync_wait(e_coro::when_all_result(
+         lookup(1),
+         lookup(-1),
+         [&]() -> task<result<int, errc>> {
+            started = true;
+            co_return 3;
+         }()));
+
+      REQUIRE(!started);
+      REQUIRE(!r.has_value());
+      REQUIRE(r.error() == errc::not_found);
+   }
+}
@@ -0,0 +1,92 @@
+#include <catch.hpp>
+#include <e-coro/scheduler/schedule_on.h>
+#include <e-coro/scheduler/static_thread_pool.h>
+#include <e-coro/core/task.h>
+#include <e-coro/core/sync_wait_task.h>
+#include "allocations.h"
+#include <thread>
+
+namespace {
+   using e_coro::task;
+   using e_coro::sync_wait;
+   using e_coro::schedule_on;
+   using e_coro::resume_on;
+   using e_coro::static_thread_pool;
+
+   static_assert(e_coro::scheduler_concept<static_thread_pool>);
+   static_assert(!e_coro::scheduler_concept<task<>>);
+
+   auto thread_id() -> task<std::thread::id> {
+      co_return std::this_thread::get_id();
+   }
+
+   TEST_CASE("schedule_on starts the awaitable on the scheduler") {
+      static_thread_pool pool{1};
+      auto main_id = std::this_thread::get_id();
+
+      auto [started_on, resumed_on] = sync_wait([&]() -> task<std::pair<std::thread::id, std::thread::id>> {
+         auto started_on = co_await schedule_on(pool, thread_id());
+         co_return std::pair{started_on, std::this_thread::get_id()};
+      }());
+
+      REQUIRE(started_on != main_id);
+      REQUIRE(resumed_on == started_on);
+   }
+
+   TEST_CASE("schedule_on an lvalue awaitable") {
+      static_thread_pool pool{1};
+      auto t = thread_id();
+      auto id = sync_wait([&]() -> task<std::thread::id> {
+         co_return co_await schedule_on(pool, t);
+      }());
+      REQUIRE(id != std::this_thread::get_id());
+   }
+
+   TEST_CASE("resume_on moves the continuation back") {
+      static_thread_pool cpu{1};
+      static_thread_pool io{1};
+
+      auto [io_id, cpu_id, resumed_on] = sync_wait([&]() -> task<std::tuple<std::thread::id, std::thread::id, std::thread::id>> {
+         co_await io.schedule();
+         auto io_id = std::this_thread::get_id();
+         auto cpu_id = co_await resume_on(io, schedule_on(cpu, thread_id()));
+         co_return std::tuple{io_id, cpu_id, std::this_thread::get_id()};
+      }());
+
+      REQUIRE(cpu_id != io_id);
+      REQUIRE(resumed_on == io_id);
+   }
+
+   TEST_CASE("resume_on a ready awaitable") {
+      static_thread_pool pool{1};
+      auto t = [](int x) -> task<int> { co_return x; };
+      auto value = sync_wait([&]() -> task<std::pair<int, bool>> {
+         auto x = co_await resume_on(pool, t(7));
+         co_return std::pair{x, pool.current_worker_index() == 0};
+      }());
+      REQUIRE(value.first == 7);
+      REQUIRE(value.second);
+   }
+
+   TEST_CASE("schedule_on and resume_on don't allocate but for the awaitable") {
+      static_thread_pool cpu{1};
+      static_thread_pool io{1};
+      auto t = [](int x) -> task<int> { co_return x; };
+
+      auto counts = sync_wait([&]() -> task<std::pair<std::size_t, std::size_t>> {
+         // the tracing and stats hooks, if on, allocate once per thread.
+         (void)co_await resume_on(io, schedule_on(cpu, t(0)));
+         auto x = t(1);
+         auto y = t(2);
+         auto before = allocations.load();
+         (void)co_await schedule_on(cpu, x);
+         auto scheduled = allocations.load() - before;
+
+         before = allocations.load();
+         (void)co_await resume_on(io, schedule_on(cpu, y));
+         co_return std::pair{scheduled, allocations.load() - before};
+      }());
+      REQUIRE(counts.first == 0);
+      REQUIRE(counts.second == 0);
+   }
+}
@@ -8,7 +8,11 @@
 #include <e-coro/core/when_all_ready.h>
 #include <e-coro/core/single_consumer_event.h>
 #include <e-coro/core/fmap.h>
+#include <e-coro/core/value_task.h>
+#include <e-coro/core/detail/inline_driver.h>
 #include "counted.h"
+#include <array>
+#include <string>
 
 namespace {
 
@@ -272,6 +276,143 @@ namespace {
       CHECK(sync_wait(t) == "pre_base_post");
    }
 
+   TEST_CASE("fmap pipeline is fused into a single awaitable") {
+      using e_coro::task;
+      using e_coro::fmap;
+      using e_coro::sync_wait;
+
+      auto one = []() -> task<int> {
+         co_return 1;
+      };
+
+      bool tapped = false;
+
+      auto t = one()
+               | fmap([](int x) { return x + 1; })
+               | fmap([](int x) { return x * 2; })
+               | fmap([](int x) { return x + 3; })
+               | fmap([](int x) { return x * 4; })
+               | fmap([](int x) { return x + 5; })
+               | fmap([](int x) { return x * 6; })
+               | fmap([](int x) { return x + 7; })
+               | fmap([](int x) { return x * 8; })
+               | fmap([](int x) { return x + 9; })
+               | fmap([](int x) { return x * 10; });
+
+      // stateless stages cost nothing, it's still a task plus nothing else.
+      static_assert(sizeof(t) == sizeof(task<int>));
+      REQUIRE(sync_wait(t) == ((((((2 * 2 + 3) * 4 + 5) * 6 + 7) * 8) + 9) * 10));
+
+      auto v = one()
+               | fmap([&](int) { tapped = true; })
+               | fmap([] { return std::string{"void in between"}; })
+               | fmap([](std::string&& s) { return std::move(s); })
+               | fmap([](const std::string& s) { return s.size(); });
+      REQUIRE(sync_wait(v) == 15);
+      REQUIRE(tapped);
+   }
+
+   TEST_CASE("when_all_ready awaits any kind of awaiter in place") {
+      e_coro::single_consumer_event event;
+      int value = 1;
+      // a bool await_suspend, which completes in place; lvalues are kept by reference.
+      auto set_event = [&]() -> e_coro::task<> {
+         event.set();
+         co_return;
+      };
+      auto setting = e_coro::when_all_ready(set_event());
+
+      auto [by_event, by_ref, by_value, nested] = e_coro::sync_wait(e_coro::when_all_ready(
+         // suspended on a void await_suspend, resumed by the last child.
+         event,
+         [&]() -> e_coro::task<int&> { co_return value; }(),
+         [&]() -> e_coro::task<std::string> { co_return std::string(100, 'x'); }(),
+         setting));
+
+      REQUIRE(&by_ref.result() == &value);
+      REQUIRE(std::move(by_value).result() == std::string(100, 'x'));
+      (void)by_event;
+      (void)nested;
+   }
+
+   TEST_CASE("when_all_ready results by rvalue reference move along with the children") {
+      auto [a, b] = e_coro::sync_wait(e_coro::when_all_ready(
+         e_coro::value_task<std::string>{std::string(100, 'x')},
+         e_coro::value_task<std::string>{[]() -> e_coro::task<std::string> { co_return std::string(50, 'y'); }()}));
+      REQUIRE(a.result().size() == 100);
+      REQUIRE(std::move(b).result() == std::string(50, 'y'));
+   }
+
+   TEST_CASE("when_all_ready children are awaited in place") {
+      using awaitable_t = decltype(e_coro::when_all_ready(std::declval<e_coro::task<int>>()));
+      using child_t = std::tuple_element_t<0, std::remove_cvref_t<e_coro::await_result_t<awaitable_t>>>;
+      static_assert(std::is_same_v<child_t, e_coro::detail::when_all_awaiter_task<e_coro::task<int>>>);
+   }
+
+   TEST_CASE("when_all_ready children that suspend are driven in their inline_frame") {
+      using e_coro::detail::inline_frame;
+      auto before = inline_frame::overflows();
+      e_coro::single_consumer_event events[2];
+      auto waiting = [](e_coro::single_consumer_event& event) -> e_coro::task<int> {
+         co_await event;
+         co_return 1;
+      };
+
+      auto [a, b, c] = e_coro::sync_wait(e_coro::when_all_ready(waiting(events[0]), waiting(events[1]), [&]() -> e_coro::task<int> {
+         for(auto& event : events) event.set();
+         co_return 2;
+      }()));
+      REQUIRE(a.result() + b.result() + c.result() == 4);
+      REQUIRE(inline_frame::overflows() == before);
+   }
+
+   auto too_large(e_coro::detail::inline_frame&, e_coro::single_consumer_event& event, int& sum)
+      -> e_coro::detail::inline_driver {
+      std::array<int, 64> values{};
+      for(std::size_t i = 0; i < values.size(); ++i) values[i] = static_cast<int>(i);
+      co_await event;
+      for(auto v : values) sum += v;
+   }
+
+   TEST_CASE("a driver that doesn't fit into its inline_frame is allocated, and counted") {
+      using e_coro::detail::inline_frame;
+      auto before = inline_frame::overflows();
+      inline_frame frame;
+      e_coro::single_consumer_event event;
+      int sum = 0;
+
+      auto driver = too_large(frame, event, sum).handle_;
+      REQUIRE(inline_frame::overflows() == before + 1);
+      driver.promise().on_done_ = [](void*) noexcept -> std::coroutine_handle<> {
+         return std::noop_coroutine();
+      };
+      driver.resume();
+      event.set();
+      REQUIRE(driver.done());
+      REQUIRE(sum == 64 * 63 / 2);
+      driver.destroy();
+   }
+
+#if !(E_CORO_TRACING || E_CORO_ASYNC_STACK || E_CORO_TASK_STATS)
+   TEST_CASE("a task promise is no more than the caller and the result") {
+      using e_coro::detail::task_promise;
+      constexpr auto caller = sizeof(std::coroutine_handle<>);
+
+      // no flag of its own for the result, it's in the caller.
+      static_assert(sizeof(task_promise<void>) == caller);
+      static_assert(sizeof(task_promise<int>) == caller + sizeof(int) + 4);
+      static_assert(sizeof(task_promise<double>) == caller + sizeof(double));
+      static_assert(sizeof(task_promise<std::string>) == caller + sizeof(std::string));
+      static_assert(sizeof(task_promise<counted>) == caller + sizeof(counted) + 4);
+      static_assert(sizeof(task_promise<int&>) == caller + sizeof(int*));
+      // and the caller of a result task is where an error is propagated to.
+      static_assert(sizeof(task_promise<e_coro::result<int, int>>) ==
+         caller + sizeof(e_coro::result<int, int>) + sizeof(void*));
+      static_assert(sizeof(task_promise<e_coro::result<void, int>>) ==
+         caller + sizeof(e_coro::result<void, int>) + sizeof(void*));
+   }
+#endif
+
 //   TEST_CASE("lots of synchronous completions doesn't result in stack-overflow") {
 //      auto completes_synchronously = []() -> e_coro::task<int> {
 //         co_return 1;
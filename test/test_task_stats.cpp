@@ -0,0 +1,156 @@
+#include <catch.hpp>
+#include <e-coro/debug/task_stats.h>
+#include <e-coro/core/task.h>
+#include <e-coro/core/sync_wait_task.h>
+#include <e-coro/core/when_all_ready.h>
+#include <e-coro/core/single_consumer_event.h>
+#include <chrono>
+#include <coroutine>
+#include <memory>
+#include <thread>
+
+#if E_CORO_TASK_STATS
+
+namespace {
+   using e_coro::task;
+   using e_coro::sync_wait;
+   using e_coro::latency_histogram;
+
+   static_assert(latency_histogram::bucket_of(0) == 0);
+   static_assert(latency_histogram::bucket_of(3) == 3);
+   static_assert(latency_histogram::bucket_of(4) == 4);
+   static_assert(latency_histogram::bucket_of(7) == 7);
+   static_assert(latency_histogram::bucket_of(8) == 8);
+   static_assert(latency_histogram::bucket_of(10) == 9);
+   static_assert(latency_histogram::lower_bound(latency_histogram::bucket_of(1000)) == 896);
+   static_assert(latency_histogram::bucket_of(~0ULL) == latency_histogram::buckets - 1);
+
+   // around the last bucket, from 2^40ns on.
+   static_assert(latency_histogram::bucket_of(1ULL << 39) == latency_histogram::buckets - 5);
+   static_assert(latency_histogram::bucket_of((1ULL << 40) - 1) == latency_histogram::buckets - 2);
+   static_assert(latency_histogram::bucket_of(1ULL << 40) == latency_histogram::buckets - 1);
+   static_assert(latency_histogram::lower_bound(latency_histogram::buckets - 1) == 1ULL << 40);
+
+   // each bucket is filled by its least value.
+   static_assert([] {
+      for(std::size_t i = 0; i < latency_histogram::buckets; ++i) {
+         if(latency_histogram::bucket_of(latency_histogram::lower_bound(i)) != i) return false;
+      }
+      return true;
+   }());
+
+   auto stats_of(std::string_view function) -> e_coro::task_stats {
+      for(auto& s : e_coro::task_stats_snapshot()) {
+         if(s.name_.find(function) != std::string_view::npos) return s;
+      }
+      return {};
+   }
+
+   auto waiting_for(e_coro::single_consumer_event& event) -> task<int> {
+      co_await event;
+      co_return 1;
+   }
+
+   TEST_CASE("a task is tagged by its coroutine") {
+      e_coro::single_consumer_event event;
+
+      sync_wait(e_coro::when_all_ready(
+         waiting_for(event),
+         [&]() -> task<> {
+            std::this_thread::sleep_for(std::chrono::milliseconds{2});
+            event.set();
+            co_return;
+         }()));
+
+      auto stats = stats_of("waiting_for");
+      REQUIRE(stats.resumes_ == 1);
+      // before it's suspended, and after it's resumed.
+      REQUIRE(stats.running_.count() == 2);
+      REQUIRE(stats.suspended_.count() == 1);
+      REQUIRE(stats.suspended_ns_ >= 2'000'000);
+      REQUIRE(stats.suspended_.percentile(0.5) >= 1'000'000);
+   }
+
+   auto returning_one() -> task<int> {
+      co_return 1;
+   }
+
+   auto awaiting_ready() -> task<int> {
+      int sum = 0;
+      for(int i = 0; i < 10; ++i) sum += co_await returning_one();
+      co_return sum;
+   }
+
+   // doesn't suspend after all, as await_suspend gives S back.
+   template<typename S>
+   struct not_suspending {
+      auto await_ready() const noexcept { return false; }
+      auto await_suspend(std::coroutine_handle<> self) const noexcept -> S {
+         if constexpr(std::is_same_v<S, bool>) return false;
+         else return self;
+      }
+      auto await_resume() const noexcept {}
+   };
+
+   auto never_suspending() -> task<> {
+      co_await std::suspend_never{};
+      co_await not_suspending<bool>{};
+      co_await not_suspending<std::coroutine_handle<>>{};
+   }
+
+   TEST_CASE("an await that doesn't suspend is no resumption") {
+      sync_wait(never_suspending());
+
+      auto stats = stats_of("never_suspending");
+      REQUIRE(stats.resumes_ == 0);
+      REQUIRE(stats.running_.count() == 1);
+      REQUIRE(stats.suspended_.count() == 0);
+   }
+
+   TEST_CASE("each resumption is counted") {
+      REQUIRE(sync_wait(awaiting_ready()) == 10);
+
+      auto stats = stats_of("awaiting_ready");
+      REQUIRE(stats.resumes_ == 10);
+      REQUIRE(stats.running_.count() == 11);
+      REQUIRE(stats_of("returning_one").running_.count() == 10);
+   }
+
+   TEST_CASE("a task with no slot left in its table is counted as dropped") {
+      using e_coro::detail::task_stats_table;
+      // the tables of this suite are large enough.
+      REQUIRE(e_coro::task_stats_dropped() == 0);
+
+      auto table = std::make_unique<task_stats_table>();
+      static char names[task_stats_table::slots + 1];
+      for(std::size_t i = 0; i < task_stats_table::slots; ++i) {
+         REQUIRE(table->find(&names[i]) != nullptr);
+      }
+      REQUIRE(table->find(&names[task_stats_table::slots]) == nullptr);
+      REQUIRE(table->dropped_.get() == 1);
+      // one in already is still found.
+      REQUIRE(table->find(&names[0]) != nullptr);
+      REQUIRE(table->dropped_.get() == 1);
+   }
+
+   auto quick_child() -> task<int> {
+      co_return 1;
+   }
+
+   auto awaiting_quick() -> task<int> {
+      co_return co_await quick_child();
+   }
+
+   TEST_CASE("a task started and done right away takes over the readings of its caller") {
+      REQUIRE(sync_wait(awaiting_quick()) == 1);
+
+      // the same 2 readings: it runs exactly while its caller is suspended.
+      auto caller = stats_of("awaiting_quick");
+      auto child = stats_of("quick_child");
+      REQUIRE(caller.resumes_ == 1);
+      REQUIRE(child.running_.count() == 1);
+      REQUIRE(caller.suspended_ns_ == child.running_ns_);
+   }
+}
+
+#endif
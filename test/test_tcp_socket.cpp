@@ -0,0 +1,173 @@
+#include <catch.hpp>
+#include <e-coro/io/tcp_socket.h>
+#include <e-coro/core/task.h>
+#include <e-coro/core/when_all_ready.h>
+#include <e-coro/core/sync_wait_task.h>
+#include "running_reactor.h"
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+   using e_coro::task;
+   using e_coro::sync_wait;
+   using e_coro::tcp_socket;
+   using e_coro::tcp_listener;
+   using e_coro::socket_address;
+
+   auto as_bytes(std::string_view s) -> std::span<const std::byte> {
+      return std::as_bytes(std::span{s.data(), s.size()});
+   }
+
+   // till the end of stream.
+   auto recv_all(tcp_socket& socket) -> task<std::string> {
+      std::string received;
+      std::vector<std::byte> buffer(64 * 1024);
+      while(true) {
+         auto n = co_await socket.recv(buffer);
+         REQUIRE(n.has_value());
+         if(*n == 0) break;
+         received.append(reinterpret_cast<const char*>(buffer.data()), *n);
+      }
+      co_return received;
+   }
+
+   TEST_CASE("tcp_socket echoes over loopback") {
+      running_reactor r;
+      auto& reactor = r.reactor_;
+
+      auto echoed = sync_wait([&]() -> task<std::string> {
+         co_await reactor.schedule();
+         auto listener = tcp_listener::listen(reactor, socket_address::loopback(0));
+         REQUIRE(listener.has_value());
+         auto address = listener->local_address();
+
+         auto server = [&]() -> task<> {
+            auto socket = co_await listener->accept();
+            REQUIRE(socket.has_value());
+            auto received = co_await recv_all(*socket);
+            auto sent = co_await socket->send(as_bytes(received));
+            REQUIRE(sent.has_value());
+            REQUIRE(*sent == received.size());
+         };
+
+         auto client = [&]() -> task<std::string> {
+            auto socket = co_await tcp_socket::connect(reactor, address);
+            REQUIRE(socket.has_value());
+            REQUIRE(!socket->set_no_delay(true));
+            std::string_view parts[] = {"hello", ", ", "world"};
+            ::iovec chain[3];
+            for(std::size_t i = 0; i < 3; ++i) {
+               chain[i] = ::iovec{const_cast<char*>(parts[i].data()), parts[i].size()};
+            }
+            auto sent = co_await socket->send(std::span<const ::iovec>{chain});
+            REQUIRE(*sent == 12);
+            REQUIRE(!socket->shutdown_send());
+            co_return co_await recv_all(*socket);
+         };
+
+         auto [served, replied] = co_await e_coro::when_all_ready(server(), client());
+         (void)served;
+         co_return std::move(replied).result();
+      }());
+
+      REQUIRE(echoed == "hello, world");
+   }
+
+   TEST_CASE("tcp_socket receives into a buffer chain") {
+      running_reactor r;
+      auto& reactor = r.reactor_;
+
+      auto received = sync_wait([&]() -> task<std::string> {
+         co_await reactor.schedule();
+         auto listener = tcp_listener::listen(reactor, socket_address::loopback(0));
+         auto client = co_await tcp_socket::connect(reactor, listener->local_address());
+         auto server = co_await listener->accept();
+         REQUIRE(server.has_value());
+
+         (void)co_await client->send(as_bytes("0123456789"));
+         char head[4], tail[6];
+         ::iovec chain[] = {{head, sizeof(head)}, {tail, sizeof(tail)}};
+         std::size_t total = 0;
+         while(total < 10) {
+            auto n = co_await server->recv(std::span<const ::iovec>{chain});
+            REQUIRE(n.has_value());
+            total += *n;
+            // not the case on loopback, the 10 bytes are there at once.
+            REQUIRE(total == 10);
+         }
+         co_return std::string{head, 4} + "|" + std::string{tail, 6};
+      }());
+
+      REQUIRE(received == "0123|456789");
+   }
+
+   TEST_CASE("tcp_socket sends a large buffer with zero copy") {
+      running_reactor r;
+      auto& reactor = r.reactor_;
+
+      std::string payload(4 * 1024 * 1024, '\0');
+      for(std::size_t i = 0; i < payload.size(); ++i) {
+         payload[i] = static_cast<char>('a' + i % 26);
+      }
+
+      auto received = sync_wait([&]() -> task<std::string> {
+         co_await reactor.schedule();
+         auto listener = tcp_listener::listen(reactor, socket_address::loopback(0));
+         REQUIRE(listener.has_value());
+         auto address = listener->local_address();
+
+         auto server = [&]() -> task<std::string> {
+            auto socket = co_await listener->accept();
+            co_return co_await recv_all(*socket);
+         };
+
+         auto client = [&]() -> task<> {
+            auto socket = co_await tcp_socket::connect(reactor, address);
+            REQUIRE(socket.has_value());
+            // not every kernel has it; the send is copied then.
+            (void)socket->enable_zerocopy();
+            auto sent = co_await socket->send(as_bytes(payload));
+            REQUIRE(sent.has_value());
+            REQUIRE(*sent == payload.size());
+         };
+
+         auto [served, sent] = co_await e_coro::when_all_ready(server(), client());
+         (void)sent;
+         co_return std::move(served).result();
+      }());
+
+      REQUIRE(received == payload);
+   }
+
+   TEST_CASE("tcp_socket fails to connect to nobody") {
+      running_reactor r;
+      auto& reactor = r.reactor_;
+
+      auto error = sync_wait([&]() -> task<std::error_code> {
+         co_await reactor.schedule();
+         // a port just freed, nobody's listening on it.
+         auto address = tcp_listener::listen(reactor, socket_address::loopback(0))->local_address();
+         auto socket = co_await tcp_socket::connect(reactor, address);
+         REQUIRE(!socket.has_value());
+         co_return socket.error();
+      }());
+
+      REQUIRE(error == std::errc::connection_refused);
+   }
+
+   TEST_CASE("socket_address parses numeric addresses") {
+      auto v4 = socket_address::parse("127.0.0.1", 80);
+      REQUIRE(v4.has_value());
+      REQUIRE(v4->family() == AF_INET);
+      REQUIRE(v4->port() == 80);
+      REQUIRE(*v4 == socket_address::loopback(80));
+
+      auto v6 = socket_address::parse("::1", 8080);
+      REQUIRE(v6->family() == AF_INET6);
+      REQUIRE(v6->port() == 8080);
+
+      REQUIRE(!socket_address::parse("localhost", 80).has_value());
+   }
+}
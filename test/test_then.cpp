@@ -0,0 +1,204 @@
+#include <catch.hpp>
+#include <e-coro/core/then.h>
+#include <e-coro/core/fmap.h>
+#include <e-coro/core/task.h>
+#include <e-coro/core/sync_wait_task.h>
+#include <e-coro/core/when_all_ready.h>
+#include <e-coro/core/single_consumer_event.h>
+#include "counted.h"
+#include "allocations.h"
+#include <deque>
+#include <string>
+
+namespace {
+   using e_coro::task;
+   using e_coro::result;
+   using e_coro::unexpected;
+   using e_coro::sync_wait;
+   using e_coro::then;
+   using e_coro::and_then;
+   using e_coro::tap;
+   using e_coro::filter;
+   using e_coro::via;
+   using e_coro::fmap;
+
+   enum class errc { failed = 1 };
+
+   auto one() -> task<int> {
+      co_return 1;
+   }
+
+   TEST_CASE("then binds the next awaitable") {
+      auto twice = [](const int& x) -> task<std::string> {
+         co_return std::to_string(x * 2);
+      };
+
+      auto t = one() | then(twice) | fmap([](const std::string& s) { return s + "!"; });
+      REQUIRE(sync_wait(t) == "2!");
+   }
+
+   TEST_CASE("then after asynchronous completion") {
+      e_coro::single_consumer_event event;
+      auto f = [&]() -> task<int> {
+         co_await event;
+         co_return 10;
+      };
+
+      auto t = f() | then([](int x) -> task<int> { co_return x + 1; });
+
+      sync_wait(e_coro::when_all_ready(
+         [&]() -> task<> {
+            CHECK(co_await t == 11);
+         }(),
+         [&]() -> task<> {
+            event.set();
+            co_return;
+         }()));
+   }
+
+   TEST_CASE("then on void awaitable passes no argument") {
+      bool reached = false;
+      auto f = [&]() -> task<> {
+         reached = true;
+         co_return;
+      };
+
+      auto t = f() | then([&]() -> task<int> { co_return reached ? 1 : 0; });
+      REQUIRE(sync_wait(t) == 1);
+   }
+
+   TEST_CASE("and_then only runs on success") {
+      auto lookup = [](int key) -> task<result<int, errc>> {
+         if(key < 0) co_return unexpected{errc::failed};
+         co_return key;
+      };
+
+      int called = 0;
+      auto next = [&](int x) -> task<result<std::string, errc>> {
+         ++called;
+         co_return std::to_string(x);
+      };
+
+      auto ok = sync_wait(lookup(3) | and_then(next));
+      REQUIRE(*ok == "3");
+      REQUIRE(called == 1);
+
+      auto ko = sync_wait(lookup(-1) | and_then(next));
+      REQUIRE(!ko.has_value());
+      REQUIRE(ko.error() == errc::failed);
+      REQUIRE(called == 1);
+   }
+
+   TEST_CASE("tap sees the value without copying it") {
+      counted::reset_counts();
+      auto make = []() -> task<counted> {
+         co_return counted{};
+      };
+
+      int seen = -1;
+      {
+         auto c = sync_wait(make() | tap([&](const counted& c) { seen = c.id; }));
+         REQUIRE(seen == 0);
+         REQUIRE(c.id == 0);
+      }
+      REQUIRE(counted::copy_construction_count == 0);
+   }
+
+   TEST_CASE("filter gives an optional") {
+      auto even = [](int x) { return x % 2 == 0; };
+      REQUIRE(!sync_wait(one() | filter(even)).has_value());
+      REQUIRE(*sync_wait(one() | fmap([](int x) { return x + 1; }) | filter(even)) == 2);
+   }
+
+   struct manual_scheduler {
+      struct schedule_awaiter {
+         auto await_ready() const noexcept { return false; }
+         auto await_suspend(std::coroutine_handle<> caller) noexcept {
+            scheduler_.queue_.push_back(caller);
+         }
+         auto await_resume() noexcept {}
+         manual_scheduler& scheduler_;
+      };
+
+      auto schedule() noexcept {
+         return schedule_awaiter{*this};
+      }
+
+      auto run() {
+         while(!queue_.empty()) {
+            auto h = queue_.front();
+            queue_.pop_front();
+            h.resume();
+         }
+      }
+
+      std::deque<std::coroutine_handle<>> queue_;
+   };
+
+   TEST_CASE("via resumes the continuation on the scheduler") {
+      manual_scheduler scheduler;
+      bool resumed = false;
+
+      auto f = [&]() -> task<> {
+         auto value = co_await (one() | via(scheduler));
+         CHECK(value == 1);
+         resumed = true;
+      };
+
+      sync_wait(e_coro::when_all_ready(
+         f(),
+         [&]() -> task<> {
+            CHECK(!resumed);
+            CHECK(scheduler.queue_.size() == 1);
+            scheduler.run();
+            CHECK(resumed);
+            co_return;
+         }()));
+   }
+
+   // ready with a value, right away.
+   template<typename T>
+   struct just {
+      auto await_ready() const noexcept { return true; }
+      auto await_suspend(std::coroutine_handle<>) const noexcept {}
+      auto await_resume() const noexcept -> T { return value_; }
+      T value_;
+   };
+
+   TEST_CASE("then, and_then and via allocate nothing once the first suspends") {
+      e_coro::single_consumer_event events[3];
+      manual_scheduler scheduler;
+      auto waiting = [](e_coro::single_consumer_event& event) -> task<int> {
+         co_await event;
+         co_return 1;
+      };
+      auto waiting_result = [](e_coro::single_consumer_event& event) -> task<result<int, errc>> {
+         co_await event;
+         co_return 1;
+      };
+
+      std::size_t allocated = ~std::size_t{0};
+      int sum = 0;
+      auto awaiting = [&]() -> task<> {
+         auto a = waiting(events[0]);
+         auto b = waiting_result(events[1]);
+         auto c = waiting(events[2]);
+         auto before = allocations.load();
+         sum += co_await (std::move(a) | then([](int x) { return just<int>{x + 1}; }));
+         auto r = co_await (std::move(b) | and_then([](int x) { return just<result<int, errc>>{x + 1}; }));
+         sum += *r;
+         sum += co_await (std::move(c) | via(scheduler));
+         allocated = allocations.load() - before;
+      };
+
+      sync_wait(e_coro::when_all_ready(
+         awaiting(),
+         [&]() -> task<> {
+            for(auto& event : events) event.set();
+            scheduler.run();
+            co_return;
+         }()));
+      REQUIRE(sum == 5);
+      REQUIRE(allocated == 0);
+   }
+}
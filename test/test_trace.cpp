@@ -0,0 +1,166 @@
+#include <catch.hpp>
+#include <e-coro/trace/chrome_trace.h>
+#include <e-coro/core/task.h>
+#include <e-coro/core/sync_wait_task.h>
+#include <e-coro/core/when_all_ready.h>
+#include <e-coro/core/single_consumer_event.h>
+#include <e-coro/core/try_await.h>
+#include <e-coro/debug/task_stats.h>
+#include <algorithm>
+#include <coroutine>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if E_CORO_TRACING
+
+namespace {
+   using e_coro::task;
+   using e_coro::sync_wait;
+   using e_coro::trace_event;
+
+   auto records() {
+      std::map<const void*, std::vector<trace_event>> frames;
+      e_coro::trace::registry::instance().for_each([&](const e_coro::trace::ring& ring) {
+         ring.for_each([&](const e_coro::trace_record& r) {
+            frames[r.frame_].push_back(r.event_);
+         });
+      });
+      return frames;
+   }
+
+   auto count(const std::string& s, const std::string& what) {
+      std::size_t n = 0;
+      for(auto i = s.find(what); i != std::string::npos; i = s.find(what, i + 1)) ++n;
+      return n;
+   }
+
+   auto inner() -> task<int> {
+      co_return 1;
+   }
+
+   auto outer() -> task<int> {
+      co_return co_await inner() + 1;
+   }
+
+   TEST_CASE("lifecycle of a task is traced") {
+      e_coro::trace::clear();
+      REQUIRE(sync_wait(outer()) == 2);
+
+      auto frames = records();
+      // sync_wait, outer and inner.
+      REQUIRE(frames.size() == 3);
+
+      using events = std::vector<trace_event>;
+      auto awaiting = events{
+         trace_event::create, trace_event::start, trace_event::suspend,
+         trace_event::resume, trace_event::complete, trace_event::destroy};
+      auto awaited = events{
+         trace_event::create, trace_event::start, trace_event::complete, trace_event::destroy};
+
+      std::size_t n_awaiting = 0, n_awaited = 0;
+      for(auto& [frame, e] : frames) {
+         if(e == awaiting) ++n_awaiting;
+         else if(e == awaited) ++n_awaited;
+      }
+      REQUIRE(n_awaiting == 2);
+      REQUIRE(n_awaited == 1);
+   }
+
+   // doesn't suspend after all, as await_suspend gives S back.
+   template<typename S>
+   struct not_suspending {
+      auto await_ready() const noexcept { return false; }
+      auto await_suspend(std::coroutine_handle<> self) const noexcept -> S {
+         if constexpr(std::is_same_v<S, bool>) return false;
+         else return self;
+      }
+      auto await_resume() const noexcept {}
+   };
+
+   TEST_CASE("an await that doesn't suspend is not traced") {
+      e_coro::trace::clear();
+      sync_wait([]() -> task<> {
+         co_await std::suspend_never{};
+         co_await not_suspending<bool>{};
+         co_await not_suspending<std::coroutine_handle<>>{};
+      }());
+
+      auto frames = records();
+      using events = std::vector<trace_event>;
+      auto awaited = events{
+         trace_event::create, trace_event::start, trace_event::complete, trace_event::destroy};
+      // sync_wait and the task, which didn't suspend.
+      REQUIRE(frames.size() == 2);
+      REQUIRE(std::count_if(frames.begin(), frames.end(), [&](auto& f) { return f.second == awaited; }) == 1);
+   }
+
+   TEST_CASE("when_all_ready is traced and exported") {
+      e_coro::trace::clear();
+      e_coro::single_consumer_event event;
+
+      sync_wait(e_coro::when_all_ready(
+         [&]() -> task<> { co_await event; }(),
+         [&]() -> task<> { event.set(); co_return; }()));
+
+      std::ostringstream out;
+      e_coro::write_chrome_trace(out);
+      auto json = out.str();
+
+      REQUIRE(json.rfind("{\"traceEvents\":[", 0) == 0);
+      REQUIRE(json.substr(json.size() - 3) == "]}\n");
+      // sync_wait and two tasks, the children of when_all_ready have no
+      // frames of their own.
+      REQUIRE(count(json, "\"ph\":\"b\"") == 3);
+      REQUIRE(count(json, "\"ph\":\"b\"") == count(json, "\"ph\":\"e\""));
+      REQUIRE(count(json, "\"name\":\"suspend\"") == count(json, "\"name\":\"resume\""));
+   }
+
+   enum class failure { timeout };
+
+   auto failing_leaf(e_coro::single_consumer_event& event) -> task<e_coro::result<int, failure>> {
+      co_await event;
+      co_return e_coro::unexpected{failure::timeout};
+   }
+
+   auto short_circuited_middle(e_coro::single_consumer_event& event) -> task<e_coro::result<int, failure>> {
+      co_return co_await e_coro::try_await(failing_leaf(event)) + 1;
+   }
+
+   auto short_circuited_top(e_coro::single_consumer_event& event) -> task<e_coro::result<int, failure>> {
+      co_return co_await e_coro::try_await(short_circuited_middle(event)) + 1;
+   }
+
+   TEST_CASE("a task short-circuited by try_await is traced as completed") {
+      e_coro::trace::clear();
+      e_coro::single_consumer_event event;
+      std::optional<e_coro::result<int, failure>> r;
+
+      sync_wait(e_coro::when_all_ready(
+         [&]() -> task<> { r.emplace(co_await short_circuited_top(event)); }(),
+         [&]() -> task<> {
+            event.set();
+            co_return;
+         }()));
+      REQUIRE(!r->has_value());
+
+      for(auto& [frame, events] : records()) {
+         auto n = [&](trace_event e) { return std::count(events.begin(), events.end(), e); };
+         REQUIRE(n(trace_event::start) == n(trace_event::complete));
+         REQUIRE(n(trace_event::suspend) == n(trace_event::resume));
+      }
+
+#if E_CORO_TASK_STATS
+      // every slice run is closed, the last one as it's short-circuited.
+      for(auto& s : e_coro::task_stats_snapshot()) {
+         if(s.name_.find("short_circuited_") == std::string_view::npos) continue;
+         REQUIRE(s.running_.count() == s.resumes_ + 1);
+         REQUIRE(s.suspended_.count() == s.resumes_);
+      }
+#endif
+   }
+}
+
+#endif
@@ -0,0 +1,188 @@
+#include <catch.hpp>
+#include <e-coro/io/udp_socket.h>
+#include <e-coro/core/task.h>
+#include <e-coro/core/when_all_ready.h>
+#include <e-coro/core/sync_wait_task.h>
+#include "running_reactor.h"
+#include <array>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+   using e_coro::task;
+   using e_coro::sync_wait;
+   using e_coro::udp_socket;
+   using e_coro::udp_message;
+   using e_coro::socket_address;
+
+   // messages with buffers of their own.
+   struct message_buffers {
+      message_buffers(std::size_t n, std::size_t size)
+         : storage_(n * size)
+         , messages_(n) {
+         for(std::size_t i = 0; i < n; ++i) {
+            messages_[i].buffer_ = std::span{storage_}.subspan(i * size, size);
+         }
+      }
+
+      auto text(std::size_t i) const -> std::string {
+         return {reinterpret_cast<const char*>(messages_[i].buffer_.data()), messages_[i].size_};
+      }
+
+      std::vector<std::byte> storage_;
+      std::vector<udp_message> messages_;
+   };
+
+   TEST_CASE("udp_socket sends and receives datagrams in batches") {
+      running_reactor r;
+      auto& reactor = r.reactor_;
+
+      auto [received, batches] = sync_wait([&]() -> task<std::pair<std::vector<std::string>, std::size_t>> {
+         co_await reactor.schedule();
+         auto receiver = udp_socket::open(reactor, socket_address::loopback(0));
+         auto sender = udp_socket::open(reactor, socket_address::loopback(0));
+         REQUIRE(receiver.has_value());
+         REQUIRE(sender.has_value());
+
+         constexpr std::size_t total = 100;
+         std::vector<std::string> texts;
+         for(std::size_t i = 0; i < total; ++i) texts.push_back("datagram " + std::to_string(i));
+         std::vector<udp_message> outgoing(total);
+         for(std::size_t i = 0; i < total; ++i) {
+            outgoing[i].buffer_ = std::as_writable_bytes(std::span{texts[i].data(), texts[i].size()});
+            outgoing[i].address_ = receiver->local_address();
+         }
+         auto [sent, error] = co_await sender->send_batch(outgoing);
+         REQUIRE(!error);
+         REQUIRE(sent == total);
+
+         std::vector<std::string> received;
+         std::size_t batches = 0;
+         message_buffers incoming{16, 64};
+         while(received.size() < total) {
+            auto n = co_await receiver->recv_batch(incoming.messages_);
+            REQUIRE(n.has_value());
+            REQUIRE(*n <= 16);
+            ++batches;
+            for(std::size_t i = 0; i < *n; ++i) {
+               REQUIRE(incoming.messages_[i].address_ == sender->local_address());
+               REQUIRE(!incoming.messages_[i].truncated_);
+               received.push_back(incoming.text(i));
+            }
+         }
+         co_return std::pair{std::move(received), batches};
+      }());
+
+      REQUIRE(received.size() == 100);
+      for(std::size_t i = 0; i < 100; ++i) {
+         REQUIRE(received[i] == "datagram " + std::to_string(i));
+      }
+      // all of them were there already, a full batch at once.
+      REQUIRE(batches == 7);
+   }
+
+   TEST_CASE("udp_socket tells what's sent before a send failed, and why") {
+      running_reactor r;
+      auto& reactor = r.reactor_;
+
+      sync_wait([&]() -> task<> {
+         co_await reactor.schedule();
+         auto receiver = udp_socket::open(reactor, socket_address::loopback(0));
+         auto sender = udp_socket::open(reactor, socket_address::loopback(0));
+
+         std::string text = "fits";
+         // no datagram is that large.
+         std::vector<std::byte> too_large(70000);
+         std::vector<udp_message> outgoing(4);
+         for(auto& message : outgoing) {
+            message.buffer_ = std::as_writable_bytes(std::span{text.data(), text.size()});
+            message.address_ = receiver->local_address();
+         }
+         outgoing[2].buffer_ = too_large;
+
+         auto [sent, error] = co_await sender->send_batch(outgoing);
+         REQUIRE(sent == 2);
+         REQUIRE(error == std::errc::message_size);
+
+         message_buffers incoming{4, 64};
+         auto n = co_await receiver->recv_batch(incoming.messages_);
+         REQUIRE(*n == 2);
+      }());
+   }
+
+   TEST_CASE("udp_socket receives once a datagram comes") {
+      running_reactor r;
+      auto& reactor = r.reactor_;
+
+      auto text = sync_wait([&]() -> task<std::string> {
+         co_await reactor.schedule();
+         auto receiver = udp_socket::open(reactor, socket_address::loopback(0));
+         auto sender = udp_socket::open(reactor, socket_address::loopback(0));
+
+         auto send_later = [&]() -> task<> {
+            // back on the loop, after the receiver is suspended.
+            co_await reactor.schedule();
+            std::string text = "late";
+            udp_message message{std::as_writable_bytes(std::span{text.data(), text.size()}), receiver->local_address()};
+            auto sent = co_await sender->send_batch(std::span{&message, 1});
+            REQUIRE(!sent.error_);
+            REQUIRE(sent.sent_ == 1);
+         };
+         auto later = send_later();
+
+         message_buffers incoming{4, 64};
+         auto receiving = [&]() -> task<std::size_t> {
+            co_return *(co_await receiver->recv_batch(incoming.messages_));
+         };
+         auto [n, sent] = co_await e_coro::when_all_ready(receiving(), std::move(later));
+         (void)sent;
+         REQUIRE(n.result() == 1);
+         co_return incoming.text(0);
+      }());
+
+      REQUIRE(text == "late");
+   }
+
+   TEST_CASE("udp_socket segments a message by GSO, and coalesces it by GRO") {
+      running_reactor r;
+      auto& reactor = r.reactor_;
+
+      sync_wait([&]() -> task<> {
+         co_await reactor.schedule();
+         auto receiver = udp_socket::open(reactor, socket_address::loopback(0));
+         auto sender = udp_socket::open(reactor, socket_address::loopback(0));
+
+         std::vector<std::byte> payload(3000, std::byte{'g'});
+         udp_message message{payload, receiver->local_address()};
+         message.segment_size_ = 1000;
+
+         message_buffers incoming{4, 4000};
+         SECTION("segmented") {
+            auto sent = co_await sender->send_batch(std::span{&message, 1});
+            // not every kernel, or device, has it.
+            if(sent.error_) co_return;
+            std::size_t received = 0;
+            while(received < 3) {
+               auto n = co_await receiver->recv_batch(incoming.messages_);
+               for(std::size_t i = 0; i < *n; ++i) {
+                  REQUIRE(incoming.messages_[i].size_ == 1000);
+                  REQUIRE(incoming.messages_[i].segment_size_ == 0);
+               }
+               received += *n;
+            }
+            REQUIRE(received == 3);
+         }
+
+         SECTION("coalesced") {
+            if(receiver->enable_gro()) co_return;
+            auto sent = co_await sender->send_batch(std::span{&message, 1});
+            if(sent.error_) co_return;
+            auto n = co_await receiver->recv_batch(incoming.messages_);
+            REQUIRE(*n == 1);
+            REQUIRE(incoming.messages_[0].size_ == 3000);
+            REQUIRE(incoming.messages_[0].segment_size_ == 1000);
+         }
+      }());
+   }
+}
@@ -0,0 +1,98 @@
+#include <catch.hpp>
+#include <e-coro/core/value_task.h>
+#include <e-coro/core/sync_wait_task.h>
+#include <e-coro/core/single_consumer_event.h>
+#include <e-coro/core/when_all_ready.h>
+#include <e-coro/core/fmap.h>
+#include "counted.h"
+#include "allocations.h"
+#include <string>
+
+namespace {
+   using e_coro::task;
+   using e_coro::value_task;
+   using e_coro::sync_wait;
+
+   TEST_CASE("value_task constructed from value is ready without a frame") {
+      auto before = allocations.load();
+      value_task<int> t = 42;
+      REQUIRE(t.is_ready());
+
+      auto awaiter = t.operator co_await();
+      REQUIRE(awaiter.await_ready());
+      REQUIRE(awaiter.await_resume() == 42);
+      REQUIRE(allocations.load() == before);
+   }
+
+   TEST_CASE("value_task falls back to the wrapped task") {
+      bool started = false;
+      auto f = [&]() -> task<int> {
+         started = true;
+         co_return 7;
+      };
+
+      auto lookup = [&](bool hit) -> value_task<int> {
+         if(hit) return 1;
+         return f();
+      };
+
+      sync_wait([&]() -> task<> {
+         CHECK(co_await lookup(true) == 1);
+         CHECK(!started);
+
+         auto t = lookup(false);
+         CHECK(!t.is_ready());
+         CHECK(co_await t == 7);
+         CHECK(started);
+      }());
+   }
+
+   TEST_CASE("value_task of reference and void type") {
+      int value = 3;
+      value_task<int&> r{std::in_place, value};
+
+      sync_wait([&]() -> task<> {
+         decltype(auto) result = co_await r;
+         static_assert(std::is_same_v<decltype(result), int&>);
+         CHECK(&result == &value);
+
+         co_await value_task<>{std::in_place};
+         co_await value_task<>{[]() -> task<> { co_return; }()};
+      }());
+   }
+
+   TEST_CASE("value_task moves its inline result out when awaited as rvalue") {
+      counted::reset_counts();
+      {
+         auto s = sync_wait([]() -> task<counted> {
+            co_return co_await value_task<counted>{counted{}};
+         }());
+         CHECK(counted::copy_construction_count == 0);
+         CHECK(s.id == 0);
+      }
+      CHECK(counted::active_count() == 0);
+   }
+
+   TEST_CASE("value_task composes like task") {
+      using e_coro::fmap;
+      e_coro::single_consumer_event event;
+
+      auto f = [&]() -> task<int> {
+         co_await event;
+         co_return 2;
+      };
+
+      auto ready = value_task<int>{1} | fmap([](int x) { return std::to_string(x); });
+      CHECK(sync_wait(ready) == "1");
+
+      auto pending = value_task<int>{f()};
+      sync_wait(e_coro::when_all_ready(
+         [&]() -> task<> {
+            CHECK(co_await pending == 2);
+         }(),
+         [&]() -> task<> {
+            event.set();
+            co_return;
+         }()));
+   }
+}